@@ -1,10 +1,20 @@
 #include "Compass.h"
 #include <wiringPiI2C.h>
 #include <cmath>
+#include <ctime>
 #include <iostream>
 #include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
 
-Compass::Compass() : fd(-1), heading(0.0), x(0), y(0), z(0), running(false) {}
+// The IST8310 has no free running mode, single measurements are triggered back to back instead.
+// With 4x averaging a measurement is ready after roughly 3 ms, the data ready flag is polled after that.
+#define MEASUREMENT_WAIT_US 3000
+#define DATA_READY_POLL_US 500
+#define DATA_READY_MAX_POLLS 10
+
+Compass::Compass() : fd(-1), running(false), sample_rate_hz(DEFAULT_SAMPLE_RATE_HZ), missed_samples(0) {}
 
 Compass::~Compass() {
     running = false;
@@ -16,8 +26,13 @@ Compass::~Compass() {
     }
 }
 
+void Compass::set_sample_rate(float rate_hz) {
+    if (rate_hz <= 0.0) rate_hz = DEFAULT_SAMPLE_RATE_HZ;
+    if (rate_hz > MAX_SAMPLE_RATE_HZ) rate_hz = MAX_SAMPLE_RATE_HZ;
+    sample_rate_hz = rate_hz;
+}
+
 bool Compass::init() {
-    std::lock_guard<std::mutex> lock(compass_mutex);
     fd = wiringPiI2CSetup(IST8310_ADDR);
     if (fd == -1) {
         std::cerr << "Failed to initialize I2C for compass." << std::endl;
@@ -29,44 +44,102 @@ bool Compass::init() {
         return false;
     }
 
+    // Short averaging keeps the measurement time well below the sample period
+    wiringPiI2CWriteReg8(fd, IST8310_AVGCNTL, IST8310_AVG_4_TIMES);
+    wiringPiI2CWriteReg8(fd, IST8310_PDCNTL, IST8310_PULSE_NORMAL);
+
     // Start the update thread
     running = true;
     compass_thread = std::thread(&Compass::update_data, this);
-    std::cout << "Compass initialized" << std::endl;
+    std::cout << "Compass initialized (" << sample_rate_hz << " Hz)" << std::endl;
     return true;
 }
 
-int16_t Compass::read_2_bytes(uint8_t reg) {
-    uint8_t low = wiringPiI2CReadReg8(fd, reg);
-    uint8_t high = wiringPiI2CReadReg8(fd, reg + 1);
-    return (high << 8) | low;
+bool Compass::read_block(uint8_t reg, uint8_t *buffer, uint8_t length) {
+    // Register address write and data read as one combined transaction (repeated start)
+    struct i2c_msg messages[2];
+    messages[0].addr = IST8310_ADDR;
+    messages[0].flags = 0;
+    messages[0].len = 1;
+    messages[0].buf = &reg;
+    messages[1].addr = IST8310_ADDR;
+    messages[1].flags = I2C_M_RD;
+    messages[1].len = length;
+    messages[1].buf = buffer;
+
+    struct i2c_rdwr_ioctl_data transfer;
+    transfer.msgs = messages;
+    transfer.nmsgs = 2;
+    return ioctl(fd, I2C_RDWR, &transfer) == 2;
 }
 
 void Compass::update_data() {
+    const long period_ns = static_cast<long>(1e9 / sample_rate_hz);
+    struct timespec next_start;
+    clock_gettime(CLOCK_MONOTONIC, &next_start);
+
     while (running) {
-        {
-            std::lock_guard<std::mutex> lock(compass_mutex);
+        // Trigger a single measurement
+        wiringPiI2CWriteReg8(fd, IST8310_CTRL1, IST8310_MODE_SINGLE);
+        usleep(MEASUREMENT_WAIT_US);
 
-            // Enable single measurement mode
-            wiringPiI2CWriteReg8(fd, IST8310_CTRL1, 0x01);
-            usleep(10000); // Wait for measurement to complete (10 ms)
+        // STAT1 and X/Y/Z are adjacent: status and all six data bytes in one burst
+        uint8_t data[7] = {0};
+        bool ready = false;
+        for (int poll = 0; poll < DATA_READY_MAX_POLLS && running; ++poll) {
+            if (read_block(IST8310_STAT1, data, sizeof(data)) && (data[0] & IST8310_STAT1_DRDY)) {
+                ready = true;
+                break;
+            }
+            usleep(DATA_READY_POLL_US);
+        }
 
-            // Read x, y, z values
-            x = read_2_bytes(IST8310_X_LSB);
-            y = read_2_bytes(IST8310_Y_LSB);
-            // z = read_2_bytes(IST8310_Z_LSB);
+        if (ready) {
+            CompassSample sample;
+            sample.x = static_cast<int16_t>((data[IST8310_X_LSB - IST8310_STAT1 + 1] << 8) | data[IST8310_X_LSB - IST8310_STAT1]);
+            sample.y = static_cast<int16_t>((data[IST8310_Y_LSB - IST8310_STAT1 + 1] << 8) | data[IST8310_Y_LSB - IST8310_STAT1]);
+            sample.z = static_cast<int16_t>((data[IST8310_Z_LSB - IST8310_STAT1 + 1] << 8) | data[IST8310_Z_LSB - IST8310_STAT1]);
 
             // Compute heading
-            heading = atan2((double)y, (double)x) * 180.0 / M_PI - 90.0 + HEADING_OFFSET;
-            if (heading < 0) {
-                heading += 360.0; // Normalize to [0, 360]
+            sample.heading = atan2((double)sample.y, (double)sample.x) * 180.0 / M_PI - 90.0 + HEADING_OFFSET;
+            if (sample.heading < 0) {
+                sample.heading += 360.0; // Normalize to [0, 360]
             }
+
+            // Readers only ever see complete samples, nobody waits for the measurement
+            latest_sample.publish(sample);
+        } else {
+            missed_samples++;
         }
-        usleep(100000); // Sleep for 100 ms (adjust as needed)
+
+        // Pace the measurements on absolute deadlines, restart the schedule if we fell behind
+        next_start.tv_nsec += period_ns;
+        while (next_start.tv_nsec >= 1000000000L) {
+            next_start.tv_nsec -= 1000000000L;
+            next_start.tv_sec++;
+        }
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec > next_start.tv_sec || (now.tv_sec == next_start.tv_sec && now.tv_nsec > next_start.tv_nsec)) {
+            next_start = now;
+        } else {
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next_start, nullptr);
+        }
+    }
+}
+
+float Compass::get_heading() const {
+    return latest_sample.value().heading;
+}
+
+Sample<CompassSample> Compass::get_sample() const {
+    Sample<CompassSample> sample;
+    if (!latest_sample.read(sample)) {
+        sample.value = CompassSample();
     }
+    return sample;
 }
 
-float Compass::get_heading() {
-    std::lock_guard<std::mutex> lock(compass_mutex);
-    return heading;
+uint64_t Compass::get_missed_samples() const {
+    return missed_samples.load();
 }
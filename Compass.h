@@ -3,44 +3,61 @@
 
 #include <cstdint>
 #include <thread>
-#include <mutex>
 #include <atomic>
+#include "SensorInterfaces.h"
 
-class Compass {
+// IST8310 magnetometer on I2C, measured by a thread at the sample rate
+class Compass : public HeadingSource {
 private:
     int fd; // I2C file descriptor
-    std::mutex compass_mutex;
     std::atomic<bool> running; // Flag to control the thread
     std::thread compass_thread;
     static constexpr float HEADING_OFFSET = 0.0; // physical offset when mounting compass on the drone in degrees
 
-    // Latest compass data
-    float heading;
-    int16_t x, y, z;
+    // Sample rate of the measurement thread
+    static constexpr float DEFAULT_SAMPLE_RATE_HZ = 100.0;
+    static constexpr float MAX_SAMPLE_RATE_HZ = 200.0;
+    float sample_rate_hz;
+
+    // Latest compass data, written by the update thread only
+    LatestSample<CompassSample> latest_sample;
+    std::atomic<uint64_t> missed_samples;   // Measurements that were not ready in time
 
     // IST8310 I2C address and register addresses
     static constexpr uint8_t IST8310_WHO_AM_I = 0x00;
     static constexpr uint8_t IST8310_ADDR = 0x0E;
+    static constexpr uint8_t IST8310_STAT1 = 0x02;
     static constexpr uint8_t IST8310_CTRL1 = 0x0A;
     static constexpr uint8_t IST8310_X_LSB = 0x03;
     static constexpr uint8_t IST8310_Y_LSB = 0x05;
     static constexpr uint8_t IST8310_Z_LSB = 0x07;
-    
+    static constexpr uint8_t IST8310_AVGCNTL = 0x41;
+    static constexpr uint8_t IST8310_PDCNTL = 0x42;
+
     static constexpr uint8_t IST8310_DEVICE_ID = 0x10;
+    static constexpr uint8_t IST8310_STAT1_DRDY = 0x01;
+    static constexpr uint8_t IST8310_MODE_SINGLE = 0x01;
+    static constexpr uint8_t IST8310_AVG_4_TIMES = 0x12;    // 4x averaging for Y and X/Z
+    static constexpr uint8_t IST8310_PULSE_NORMAL = 0xC0;
 
     // Helper functions
-    int16_t read_2_bytes(uint8_t reg);
+    bool read_block(uint8_t reg, uint8_t *buffer, uint8_t length); // Burst read in one I2C transaction
     void update_data(); // Thread function to update compass data
 
 public:
     Compass();
     ~Compass();
 
+    // Set the measurement rate (up to 200 Hz), call before init()
+    void set_sample_rate(float rate_hz);
+
     // Initialize the compass (returns true if successful)
-    bool init();
+    bool init() override;
 
-    // Getters for compass data
-    float get_heading();
+    // Getters for compass data (lock-free)
+    float get_heading() const;
+    Sample<CompassSample> get_sample() const override;
+    uint64_t get_missed_samples() const;
 };
 
 #endif // COMPASS_H
@@ -1,15 +1,78 @@
 #include "Connector.h"
 #include <iostream>
 #include <sstream>
+#include <vector>
 #include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <netinet/in.h>
+#include <arpa/inet.h>
 #include <unistd.h>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
 #include <nlohmann/json.hpp>
+#include "MonotonicClock.h"
 
 using json = nlohmann::json;
 
+static json estimatedStateJson(const EstimatedState &state) {
+    return {
+        {"valid", state.valid},
+        {"latitude", state.position.latitude},
+        {"longitude", state.position.longitude},
+        {"altitude", state.position.altitude},
+        {"velocity_east", state.velocity_east},
+        {"velocity_north", state.velocity_north},
+        {"climb_rate", state.climb_rate},
+        {"heading", state.heading},
+        {"yaw_rate", state.yaw_rate},
+        {"position_sigma", state.position_sigma},
+        {"heading_sigma", state.heading_sigma}
+    };
+}
+
+static json ageHistogramJson(const AgeHistogram &histogram) {
+    json limits = json::array();
+    json counts = json::array();
+    for (size_t i = 0; i < AgeHistogram::BUCKET_COUNT; ++i) {
+        limits.push_back(AgeHistogram::bucket_limit_ms(i));
+        counts.push_back(histogram.get_count(i));
+    }
+    return {
+        {"last_us", histogram.get_last_age_us()},
+        {"max_us", histogram.get_max_age_us()},
+        {"stale", histogram.get_stale_count()},
+        {"bucket_limits_ms", limits},
+        {"counts", counts}
+    };
+}
+
+constexpr int Connector::IDLE_TIMEOUT_S;
+constexpr size_t Connector::MAX_OUTPUT_BUFFER;
+constexpr size_t Connector::MAX_PENDING_PUSH;
+constexpr double Connector::MAX_SUBSCRIPTION_RATE;
+
+static const char* const STREAM_NAMES[] = {"TELEMETRY", "CONTROL_STATE"};
+static const int ENCODING_COUNT = 3;   // MessageEncoding values
+static const int FRAMING_COUNT = 3;    // FramingMode values
+
+static std::string toLowerCase(std::string text) {
+    for (char& c : text) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return text;
+}
+
+// Parser messages quote the offending input, which may be any bytes: keep printable ASCII only
+static std::string printableText(std::string text) {
+    for (char& c : text) {
+        if (c < 0x20 || c > 0x7e) c = '?';
+    }
+    return text;
+}
+
 Connector::Connector(ControlLoop& controlLoop, int port)
-    : controlLoop(controlLoop), port(port), running(false) {}
+    : controlLoop(controlLoop), port(port), running(false), serverFd(-1), epollFd(-1), wakeFd(-1), clientCount(0), telemetryPublisher(nullptr),
+      targetEventCursor(0) {}
 
 Connector::~Connector() {
     stop();
@@ -17,6 +80,57 @@ Connector::~Connector() {
 
 bool Connector::start() {
     if (running) return false;
+
+    // Set up the sockets here, so a port that is already in use is reported to the caller
+    serverFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (serverFd < 0) {
+        perror("Socket failed");
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(serverFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port);
+
+    if (bind(serverFd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        perror("Bind failed");
+        closeAll();
+        return false;
+    }
+
+    if (listen(serverFd, 16) < 0) {
+        perror("Listen failed");
+        closeAll();
+        return false;
+    }
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0) {
+        perror("epoll setup failed");
+        closeAll();
+        return false;
+    }
+
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = serverFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, serverFd, &ev);
+    ev.data.fd = wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+
+    // Target events are emitted by the control thread, it only wakes up the server thread
+    targetEventCursor = controlLoop.get_target_event_count();
+    int eventFd = wakeFd;
+    controlLoop.set_event_listener([eventFd] {
+        uint64_t one = 1;
+        if (write(eventFd, &one, sizeof(one)) < 0) perror("Wakeup failed");
+    });
+
     running = true;
     serverThread = std::thread(&Connector::serverLoop, this);
     return true;
@@ -25,137 +139,663 @@ bool Connector::start() {
 void Connector::stop() {
     if (!running) return;
     running = false;
+    controlLoop.set_event_listener(nullptr);
+
+    // Wake up epoll_wait(), the server thread closes all connections on its way out
+    uint64_t one = 1;
+    if (write(wakeFd, &one, sizeof(one)) < 0) perror("Wakeup failed");
     if (serverThread.joinable()) serverThread.join();
+    closeAll();
+}
+
+size_t Connector::getClientCount() const {
+    return clientCount;
+}
+
+void Connector::setTelemetryPublisher(TelemetryPublisher* publisher) {
+    telemetryPublisher = publisher;
 }
 
 void Connector::serverLoop() {
-    int server_fd, new_socket;
-    struct sockaddr_in address;
-    int addrlen = sizeof(address);
+    std::cout << "Server running. Waiting for connections... " << std::endl;
 
-    // Create socket
-    if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) == 0) {
-        perror("Socket failed");
-        return;
+    const int MAX_EVENTS = 32;
+    struct epoll_event events[MAX_EVENTS];
+
+    while (running) {
+        // Wake up for the next subscription push, at least once a second to drop idle clients
+        int count = epoll_wait(epollFd, events, MAX_EVENTS, nextPushTimeoutMs());
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait failed");
+            break;
+        }
+
+        for (int i = 0; i < count && running; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wakeFd) {
+                uint64_t wakeups;
+                if (read(wakeFd, &wakeups, sizeof(wakeups)) < 0 && errno != EAGAIN) perror("Wakeup read failed");
+                continue;
+            }
+            if (fd == serverFd) {
+                acceptClients();
+                continue;
+            }
+
+            auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+            Connection& connection = *it->second;
+
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                closeClient(fd);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) {
+                if (!flushOutput(connection)) continue;
+            }
+            if (events[i].events & EPOLLIN) {
+                readClient(connection);
+            }
+        }
+
+        dispatchTargetEvents();
+        pushSubscriptions();
+        closeIdleClients();
     }
 
-    // Bind socket
-    address.sin_family = AF_INET;
-    address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(port);
+    closeAll();
+}
 
-    if (bind(server_fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
-        perror("Bind failed");
-        close(server_fd);
-        return;
+void Connector::acceptClients() {
+    while (true) {
+        sockaddr_in peer = {};
+        socklen_t peerLength = sizeof(peer);
+        int fd = accept4(serverFd, (struct sockaddr*)&peer, &peerLength, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) perror("Accept failed");
+            return;
+        }
+
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            perror("epoll_ctl failed");
+            close(fd);
+            continue;
+        }
+
+        std::unique_ptr<Connection> connection(new Connection());
+        connection->fd = fd;
+        connection->lastActivityNs = monotonic_ns();
+        connection->writeWatched = false;
+        connection->encoding = MessageEncoding::JSON;
+        connection->peer = peer;
+        for (int stream = 0; stream < STREAM_COUNT; ++stream) {
+            connection->pushPeriodNs[stream] = 0;
+            connection->nextPushNs[stream] = 0;
+        }
+        connections[fd] = std::move(connection);
+        clientCount = connections.size();
+        std::cout << "Client connected (" << connections.size() << " connected)" << std::endl;
     }
+}
 
-    // Listen
-    if (listen(server_fd, 3) < 0) {
-        perror("Listen failed");
-        close(server_fd);
-        return;
+void Connector::readClient(Connection& connection) {
+    int fd = connection.fd;
+    char buffer[4096];
+    bool closed = false;
+    while (true) {
+        ssize_t bytes_read = read(fd, buffer, sizeof(buffer));
+        if (bytes_read > 0) {
+            connection.decoder.append(buffer, bytes_read);
+            connection.lastActivityNs = monotonic_ns();
+            continue;
+        }
+        if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (bytes_read < 0 && errno == EINTR) continue;
+
+        // Orderly shutdown or error, commands received before it are still answered
+        closed = true;
+        break;
     }
 
-    std::cout << "Server running. Waiting for connections... " << std::endl;
+    processInput(connection);
+    if (closed && connections.count(fd)) closeClient(fd);
+}
 
-    while (running) {
-        if ((new_socket = accept(server_fd, (struct sockaddr*)&address, (socklen_t*)&addrlen)) < 0) {
-            perror("Accept failed");
+void Connector::processInput(Connection& connection) {
+    // Handle every complete command, responses of pipelined commands go out in one send
+    std::string command;
+    while (true) {
+        FrameDecoder::Result result = connection.decoder.next(command);
+        if (result == FrameDecoder::Result::INCOMPLETE) break;
+        if (result == FrameDecoder::Result::ERROR) {
+            std::cerr << "Framing error, disconnecting client" << std::endl;
+            json response = {
+                {"error", "framing error"}
+            };
+            int fd = connection.fd;
+            queueResponse(connection, connection.encoding, response);
+            if (flushOutput(connection)) closeClient(fd);
+            return;
+        }
+        MessageEncoding encoding = connection.encoding;
+        json response = handleCommand(connection, command);
+        queueResponse(connection, encoding, response);
+    }
+    flushOutput(connection);
+}
+
+void Connector::queueResponse(Connection& connection, MessageEncoding encoding, const json& response) {
+    std::string payload;
+    try {
+        payload = encodeMessage(encoding, response);
+    } catch (const json::exception &e) {
+        // Never let a response take down the reactor thread
+        std::cerr << "Cannot encode response: " << e.what() << std::endl;
+        payload = encodeMessage(encoding, json{{"error", "cannot encode response"}});
+    }
+    connection.output += encodeFrame(connection.decoder.getMode(), payload);
+}
+
+bool Connector::flushOutput(Connection& connection) {
+    int fd = connection.fd;
+    while (!connection.output.empty()) {
+        ssize_t sent = send(fd, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection.output.erase(0, sent);
             continue;
         }
-        std::cout << "Client connected" << std::endl;
-        struct timeval timeout;
-        timeout.tv_sec = 10; // Timeout for client inactivity (10 seconds)
-        timeout.tv_usec = 0;
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        closeClient(fd);
+        return false;
+    }
+
+    if (connection.output.size() > MAX_OUTPUT_BUFFER) {
+        std::cerr << "Client not reading, disconnecting" << std::endl;
+        closeClient(fd);
+        return false;
+    }
+
+    // Only watch for writability while output is pending, otherwise epoll would wake up constantly
+    bool pending = !connection.output.empty();
+    if (pending != connection.writeWatched) {
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLRDHUP | (pending ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+        ev.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev);
+        connection.writeWatched = pending;
+    }
+    return true;
+}
+
+void Connector::closeClient(int fd) {
+    auto it = connections.find(fd);
+    if (it != connections.end()) udpUnsubscribe(*it->second);
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections.erase(fd);
+    clientCount = connections.size();
+    std::cout << "Client disconnected (" << connections.size() << " connected)" << std::endl;
+}
+
+void Connector::closeIdleClients() {
+    int64_t deadline = monotonic_ns() - static_cast<int64_t>(IDLE_TIMEOUT_S) * 1000000000LL;
+    for (auto it = connections.begin(); it != connections.end();) {
+        int fd = it->first;
+        const Connection& connection = *it->second;
+        // Subscribers may only listen, dead ones are detected by failing sends instead
+        bool subscribed = false;
+        for (int stream = 0; stream < STREAM_COUNT; ++stream) subscribed |= connection.pushPeriodNs[stream] != 0;
+        bool idle = !subscribed && connection.lastActivityNs < deadline;
+        ++it;
+        if (idle) closeClient(fd);
+    }
+}
+
+json Connector::subscribe(Connection& connection, const std::string& streamName, double rate) {
+    int stream = 0;
+    while (stream < STREAM_COUNT && streamName != STREAM_NAMES[stream]) stream++;
+    if (stream == STREAM_COUNT || !(rate >= 0.0 && rate <= MAX_SUBSCRIPTION_RATE)) {
+        json response = {
+            {"error", "invalid subscription"}
+        };
+        return response;
+    }
 
-        // Set socket options for read timeout
-        setsockopt(new_socket, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout, sizeof(timeout));
+    // Rate 0 ends the subscription, otherwise the first update follows right after the ack
+    connection.pushPeriodNs[stream] = rate > 0.0 ? static_cast<int64_t>(1e9 / rate) : 0;
+    connection.nextPushNs[stream] = monotonic_ns();
 
-        while(true) {
-            char buffer[1024] = {0};
-            int bytes_read = read(new_socket, buffer, sizeof(buffer));
-            if (bytes_read <= 0) {
-                break;
+    json ackMessage = {
+        {"status", "confirmed"},
+        {"stream", streamName},
+        {"rate", rate}
+    };
+    return ackMessage;
+}
+
+void Connector::pushSubscriptions() {
+    int64_t now = monotonic_ns();
+    std::vector<Connection*> due;
+
+    for (int stream = 0; stream < STREAM_COUNT; ++stream) {
+        due.clear();
+        for (auto& entry : connections) {
+            Connection& connection = *entry.second;
+            int64_t period = connection.pushPeriodNs[stream];
+            if (period == 0 || connection.nextPushNs[stream] > now) continue;
+
+            // Keep the phase, but do not catch up on updates missed while the server was busy
+            connection.nextPushNs[stream] += period;
+            if (connection.nextPushNs[stream] <= now) connection.nextPushNs[stream] = now + period;
+
+            // Slow clients skip updates instead of queueing stale ones
+            if (connection.output.size() > MAX_PENDING_PUSH) continue;
+            due.push_back(&connection);
+        }
+        if (due.empty()) continue;
+
+        // One snapshot per stream, encoded at most once per encoding and framed once per framing mode
+        json snapshot = buildStream(static_cast<Stream>(stream));
+        std::string payloads[ENCODING_COUNT];
+        std::string frames[ENCODING_COUNT][FRAMING_COUNT];
+        for (Connection* connection : due) {
+            int encoding = static_cast<int>(connection->encoding);
+            FramingMode mode = connection->decoder.getMode();
+            std::string& frame = frames[encoding][static_cast<int>(mode)];
+            if (frame.empty()) {
+                if (payloads[encoding].empty()) payloads[encoding] = encodeMessage(connection->encoding, snapshot);
+                frame = encodeFrame(mode, payloads[encoding]);
             }
-            std::string command(buffer, bytes_read);
-            std::string response = handleCommand(command);
-            // std::cout << "Responding: " << response << std::endl;
-            send(new_socket, response.c_str(), response.size(), 0);            
+            connection->output += frame;
+        }
+    }
+
+    // Flushing may close connections, so collect the file descriptors first
+    std::vector<int> pending;
+    for (auto& entry : connections) {
+        if (!entry.second->output.empty() && !entry.second->writeWatched) pending.push_back(entry.first);
+    }
+    for (int fd : pending) {
+        auto it = connections.find(fd);
+        if (it != connections.end()) flushOutput(*it->second);
+    }
+}
+
+int Connector::nextPushTimeoutMs() const {
+    int64_t now = monotonic_ns();
+    int64_t timeout = 1000000000LL;
+    for (auto& entry : connections) {
+        for (int stream = 0; stream < STREAM_COUNT; ++stream) {
+            if (entry.second->pushPeriodNs[stream] == 0) continue;
+            int64_t remaining = entry.second->nextPushNs[stream] - now;
+            if (remaining < timeout) timeout = remaining;
+        }
+    }
+    if (timeout <= 0) return 0;
+    return static_cast<int>((timeout + 999999) / 1000000);
+}
+
+json Connector::buildStream(Stream stream) {
+    switch (stream) {
+        case STREAM_TELEMETRY: return getTelemetry();
+        case STREAM_CONTROL_STATE: return controlLoop.get_state_json();
+        default: return json();
+    }
+}
+
+void Connector::dispatchTargetEvents() {
+    // Only queued here, pushSubscriptions() flushes all pending output
+    targetEvents.clear();
+    controlLoop.get_target_events(targetEventCursor, targetEvents);
+
+    for (const ControlLoop::TargetEvent& event : targetEvents) {
+        json message = {
+            {"type", "TARGET_EVENT"},
+            {"target_id", event.target_id},
+            {"control_loop_state", static_cast<int>(event.state)},
+            {"state", ControlLoop::state_name(event.state)},
+            {"reason", event.reason},
+            {"waypoint", event.waypoint},
+            {"time_ns", event.timestamp_ns}
+        };
+        for (auto& entry : connections) {
+            Connection& connection = *entry.second;
+            bool owner = false;
+            for (uint32_t id : connection.targetIds) owner |= id == event.target_id;
+            if (owner || connection.pushPeriodNs[STREAM_CONTROL_STATE] != 0) {
+                queueResponse(connection, connection.encoding, message);
+            }
+        }
+    }
+}
+
+json Connector::udpSubscribe(Connection& connection, const json& request) {
+    if (telemetryPublisher == nullptr) {
+        json response = {
+            {"error", "UDP telemetry not available"}
+        };
+        return response;
+    }
+
+    // Defaults to the address of the client, a multicast group may be given instead
+    sockaddr_in address = connection.peer;
+    const json& portValue = request.at("port");
+    int64_t port = portValue.is_number_integer() ? portValue.get<int64_t>() : 0;
+    if (port < 1 || port > 65535) {
+        json response = {
+            {"error", "invalid port"}
+        };
+        return response;
+    }
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (request.contains("address")) {
+        std::string host = request["address"];
+        if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+            json response = {
+                {"error", "invalid address"}
+            };
+            return response;
+        }
+    }
+
+    MessageEncoding encoding = MessageEncoding::JSON;
+    if (request.contains("encoding") && !parseEncoding(request["encoding"], encoding)) {
+        json response = {
+            {"error", "unknown encoding"}
+        };
+        return response;
+    }
+
+    int id = telemetryPublisher->add_endpoint(address, encoding);
+    if (id < 0) {
+        json response = {
+            {"error", "too many UDP endpoints"}
+        };
+        return response;
+    }
+    connection.udpEndpoints.push_back(id);
+
+    char host[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &address.sin_addr, host, sizeof(host));
+    json ackMessage = {
+        {"status", "confirmed"},
+        {"address", host},
+        {"port", port},
+        {"encoding", encodingName(encoding)},
+        {"rate", telemetryPublisher->get_rate()}
+    };
+    return ackMessage;
+}
+
+json Connector::udpUnsubscribe(Connection& connection) {
+    if (telemetryPublisher != nullptr) {
+        for (int id : connection.udpEndpoints) telemetryPublisher->remove_endpoint(id);
+    }
+    connection.udpEndpoints.clear();
+    json ackMessage = {
+        {"status", "confirmed"}
+    };
+    return ackMessage;
+}
+
+json Connector::setEncoding(Connection& connection, const std::string& name) {
+    MessageEncoding encoding;
+    if (!parseEncoding(name, encoding)) {
+        json response = {
+            {"error", "unknown encoding"}
+        };
+        return response;
+    }
+    // Binary messages may contain newlines, they cannot be framed as JSON text
+    if (encoding != MessageEncoding::JSON && connection.decoder.getMode() != FramingMode::LENGTH_PREFIXED) {
+        json response = {
+            {"error", "binary encodings require length-prefixed framing"}
+        };
+        return response;
+    }
+
+    connection.encoding = encoding;
+    json ackMessage = {
+        {"status", "confirmed"},
+        {"encoding", encodingName(encoding)}
+    };
+    return ackMessage;
+}
+
+json Connector::setGains(const json& request) {
+    ParameterStore& parameters = controlLoop.get_parameters();
+    if (request.contains("axis")) {
+        ControlLoop::ControlAxis axis;
+        if (!ControlLoop::parse_axis(request["axis"].get<std::string>(), axis)) {
+            json response = {
+                {"error", "unknown axis"}
+            };
+            return response;
+        }
+        // Same as PARAM with the pid.<axis>.* parameters
+        std::string prefix = "pid." + toLowerCase(ControlLoop::axis_name(axis)) + ".";
+        json values = json::object();
+        const char* names[] = {"kp", "ki", "kd", "kff", "derivative_cutoff"};
+        for (const char* name : names) {
+            if (request.contains(name)) values[prefix + name] = request[name];
+        }
+        std::string error;
+        if (!parameters.set(values, error)) {
+            json response = {
+                {"error", error}
+            };
+            return response;
         }
-        std::cout << "Client disconnected" << std::endl;
-        close(new_socket);
     }
 
-    close(server_fd);
+    json ackMessage = {
+        {"status", "confirmed"}
+    };
+    ControlParameters current = parameters.get();
+    for (size_t index = 0; index < ControlLoop::AXIS_COUNT; ++index) {
+        const PidGains& gains = current.gains[index];
+        ackMessage["gains"][ControlLoop::axis_name(static_cast<ControlLoop::ControlAxis>(index))] = {
+            {"kp", gains.kp},
+            {"ki", gains.ki},
+            {"kd", gains.kd},
+            {"kff", gains.kff},
+            {"derivative_cutoff", gains.derivative_cutoff}
+        };
+    }
+    return ackMessage;
 }
 
-std::string Connector::handleCommand(const std::string& command) {
+json Connector::handleParameters(const json& request) {
+    ParameterStore& parameters = controlLoop.get_parameters();
+    std::string error;
+    if (request.contains("set") && !parameters.set(request["set"], error)) {
+        json response = {
+            {"error", error}
+        };
+        return response;
+    }
+    if (request.value("save", false) && !parameters.save_file("", error)) {
+        json response = {
+            {"error", error}
+        };
+        return response;
+    }
+
+    json ackMessage = {
+        {"status", "confirmed"},
+        {"version", parameters.get_version()},
+        {"parameters", parameters.to_json()}
+    };
+    return ackMessage;
+}
+
+void Connector::closeAll() {
+    for (auto& entry : connections) {
+        udpUnsubscribe(*entry.second);
+        close(entry.first);
+    }
+    connections.clear();
+    clientCount = 0;
+    if (serverFd >= 0) close(serverFd);
+    if (epollFd >= 0) close(epollFd);
+    if (wakeFd >= 0) close(wakeFd);
+    serverFd = epollFd = wakeFd = -1;
+}
+
+json Connector::handleCommand(Connection& connection, const std::string& command) {
     try {
-        // Parse the received JSON
-        json receivedData = json::parse(command);
-        std::cout << "Received: " << receivedData << std::endl;
+        // Decode the received message
+        json receivedData = decodeMessage(connection.encoding, command);
+        std::cout << "Received: " << receivedData.dump(-1, ' ', false, json::error_handler_t::replace) << std::endl;
         if (receivedData["command"] == "ABORT") {
             controlLoop.abort();
             json ackMessage = {
                 {"status", "confirmed"}
             };
-            return ackMessage.dump();
+            return ackMessage;
         }
         else if (receivedData["command"] == "TARGET") {
-            float latitude = receivedData["location"]["lat"];
-            float longitude = receivedData["location"]["lon"];
+            double latitude = receivedData["location"]["lat"];
+            double longitude = receivedData["location"]["lon"];
             float altitude = receivedData["location"]["alt"];
             float heading = receivedData["heading"];
             float linearSpeed = receivedData["speed"]["linear"];
             float yawSpeed = receivedData["speed"]["yaw"];
             float altitudeSpeed = receivedData["speed"]["altitude"];
-            controlLoop.set_target(latitude, longitude, altitude, heading, linearSpeed, altitudeSpeed, yawSpeed);
+            // Acknowledged right away, activation or abort follows as TARGET_EVENT
+            uint32_t targetId = controlLoop.set_target(latitude, longitude, altitude, heading, linearSpeed, altitudeSpeed, yawSpeed);
+            if (targetId == 0) {
+                json response = {
+                    {"error", "invalid target"}
+                };
+                return response;
+            }
+            connection.targetIds.push_back(targetId);
+            if (connection.targetIds.size() > 16) connection.targetIds.erase(connection.targetIds.begin());
             json ackMessage = {
-                {"status", "confirmed"}
+                {"status", "confirmed"},
+                {"target_id", targetId},
+                {"state", "PENDING"}
             };
-            return ackMessage.dump();
+            return ackMessage;
+        } else if (receivedData["command"] == "MISSION") {
+            // Same fields as TARGET per waypoint, plus the hold time in seconds
+            const json& list = receivedData.at("waypoints");
+            if (!list.is_array() || list.empty() || list.size() > Mission::MAX_WAYPOINTS) {
+                json response = {
+                    {"error", "invalid mission"}
+                };
+                return response;
+            }
+            std::vector<Waypoint> waypoints;
+            waypoints.reserve(list.size());
+            for (const json& item : list) {
+                Waypoint waypoint;
+                waypoint.position.latitude = item.at("location").at("lat");
+                waypoint.position.longitude = item.at("location").at("lon");
+                waypoint.position.altitude = item.at("location").at("alt");
+                waypoint.heading = item.at("heading");
+                waypoint.speed = item.at("speed").at("linear");
+                waypoint.yaw_speed = item.at("speed").at("yaw");
+                waypoint.altitude_speed = item.at("speed").at("altitude");
+                waypoint.hold_time = item.value("hold", 0.0f);
+                waypoints.push_back(waypoint);
+            }
+
+            uint32_t targetId = controlLoop.set_mission(waypoints);
+            if (targetId == 0) {
+                json response = {
+                    {"error", "invalid mission"}
+                };
+                return response;
+            }
+            connection.targetIds.push_back(targetId);
+            if (connection.targetIds.size() > 16) connection.targetIds.erase(connection.targetIds.begin());
+            json ackMessage = {
+                {"status", "confirmed"},
+                {"target_id", targetId},
+                {"waypoints", waypoints.size()},
+                {"state", "PENDING"}
+            };
+            return ackMessage;
         } else if (receivedData["command"] == "CONTROL_STATE") {
-            return controlLoop.get_json_state();
+            return controlLoop.get_state_json();
         } else if (receivedData["command"] == "TELEMETRY") {
             return getTelemetry();
+        } else if (receivedData["command"] == "SUBSCRIBE") {
+            std::string stream = receivedData["stream"];
+            double rate = receivedData["rate"];
+            return subscribe(connection, stream, rate);
+        } else if (receivedData["command"] == "UDP_SUBSCRIBE") {
+            return udpSubscribe(connection, receivedData);
+        } else if (receivedData["command"] == "UDP_UNSUBSCRIBE") {
+            return udpUnsubscribe(connection);
+        } else if (receivedData["command"] == "PID") {
+            return setGains(receivedData);
+        } else if (receivedData["command"] == "PARAM") {
+            return handleParameters(receivedData);
+        } else if (receivedData["command"] == "ENCODING") {
+            std::string encoding = receivedData["encoding"];
+            return setEncoding(connection, encoding);
         }
     } catch (const json::exception &e) {
         std::cerr << "JSON Parsing Error: " << e.what() << std::endl;
         json response = {
-            {"error", e.what()}
+            {"error", printableText(e.what())}
         };
-        return response.dump();
+        return response;
     }
 
     json response = {
         {"error", "unknown request"},
     };
-    return response.dump();
+    return response;
 }
 
 
-std::string Connector::getTelemetry() {
-    controlLoop.gps.update();
+json Connector::getTelemetry() {
+    // The control loop drains the GPS every tick, the published fix is always current
+    GpsFix fix = controlLoop.get_position_source().get_fix_sample().value;     // Consistent snapshot, fields from the same update
     json telemetry = {
         {"type", "TELEMETRY"},
         {"gps",
             {
-                {"lat", controlLoop.gps.get_latitude()},
-                {"lon", controlLoop.gps.get_longitude()},
-                {"altitude", controlLoop.gps.get_altitude_agl()},
-                {"speed", controlLoop.gps.get_speed()},
-                {"time", controlLoop.gps.get_time()},
-                {"fix_quality", controlLoop.gps.get_fix_quality()},
-                {"satellites", controlLoop.gps.get_satellites()},
-                {"reliable", controlLoop.gps.is_data_reliable()}
+                {"lat", fix.latitude},
+                {"lon", fix.longitude},
+                {"altitude", fix.altitude_agl},
+                {"speed", fix.speed},
+                {"time", fix.time},
+                {"fix_quality", fix.fix_quality},
+                {"satellites", fix.satellites},
+                {"reliable", fix.is_reliable()}
             }
         },
         {"compass",
             {
-                {"heading", controlLoop.compass.get_heading()}
+                {"heading", controlLoop.get_heading_source().get_sample().value.heading}
+            }
+        },
+        {"estimate", estimatedStateJson(controlLoop.get_state_estimator().get_state())},
+        {"gps_prediction",
+            {
+                {"fixes", controlLoop.get_state_estimator().get_prediction_count()},
+                {"last_error", controlLoop.get_state_estimator().get_last_prediction_error()},
+                {"max_error", controlLoop.get_state_estimator().get_max_prediction_error()},
+                {"rms_error", controlLoop.get_state_estimator().get_rms_prediction_error()},
+                {"rms_hold_error", controlLoop.get_state_estimator().get_rms_hold_error()}
+            }
+        },
+        {"sensor_age",
+            {
+                {"gps", ageHistogramJson(controlLoop.get_gps_age())},
+                {"compass", ageHistogramJson(controlLoop.get_compass_age())}
             }
         }
     };
-    return telemetry.dump();
+    return telemetry;
 }
\ No newline at end of file
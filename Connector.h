@@ -3,10 +3,18 @@
 
 
 #include "ControlLoop.h"
+#include "MessageFraming.h"
+#include "MessageEncoding.h"
+#include "TelemetryPublisher.h"
+#include <netinet/in.h>
+#include <vector>
+#include <nlohmann/json_fwd.hpp>
 #include <thread>
 #include <atomic>
 #include <string>
 #include <memory>
+#include <unordered_map>
+#include <cstdint>
 
 class Connector {
 public:
@@ -16,23 +24,91 @@ public:
     // Start the server
     bool start();
 
-    // Stop the server
+    // Stop the server, disconnects all clients
     void stop();
 
+    // Number of connected clients
+    size_t getClientCount() const;
+
+    // Publisher for UDP_SUBSCRIBE, set before start()
+    void setTelemetryPublisher(TelemetryPublisher* publisher);
+
+    static constexpr int IDLE_TIMEOUT_S = 10;                  // Clients without traffic are disconnected
+    static constexpr size_t MAX_OUTPUT_BUFFER = 1024 * 1024;   // Clients that do not read are disconnected
+    static constexpr size_t MAX_PENDING_PUSH = 64 * 1024;      // Pushes are skipped while more output is pending
+    static constexpr double MAX_SUBSCRIPTION_RATE = 50.0;      // Hz
+
 private:
+    // Streams a client can subscribe to with SUBSCRIBE
+    enum Stream { STREAM_TELEMETRY, STREAM_CONTROL_STATE, STREAM_COUNT };
+
+    // State of one client connection, owned by the server thread
+    struct Connection {
+        int fd;
+        FrameDecoder decoder;       // Received bytes, split into commands
+        MessageEncoding encoding;   // Encoding of the commands and responses inside the frames
+        std::string output;         // Responses not sent yet
+        int64_t lastActivityNs;
+        bool writeWatched;          // EPOLLOUT is registered because output is pending
+        int64_t pushPeriodNs[STREAM_COUNT];     // 0 if not subscribed
+        int64_t nextPushNs[STREAM_COUNT];
+        sockaddr_in peer;                       // Client address, default destination for UDP telemetry
+        std::vector<int> udpEndpoints;          // Registered with the TelemetryPublisher, removed on disconnect
+        std::vector<uint32_t> targetIds;        // Targets set by this client, their events are sent to it
+    };
+
     ControlLoop& controlLoop; // Reference to the control loop
     int port;                 // Port for the server
     std::thread serverThread; // Thread to handle server operations
     std::atomic<bool> running; // Flag to control server loop
 
-    // Server logic
+    int serverFd;             // Listening socket
+    int epollFd;
+    int wakeFd;               // eventfd to wake the server thread on stop()
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    std::atomic<size_t> clientCount;
+    TelemetryPublisher* telemetryPublisher;
+    uint64_t targetEventCursor;             // Last control loop target event forwarded to the clients
+    std::vector<ControlLoop::TargetEvent> targetEvents;
+
+    // Server logic: single threaded epoll reactor over the listening socket and all clients
     void serverLoop();
+    void acceptClients();
+    void readClient(Connection& connection);
+    void processInput(Connection& connection);
+    bool flushOutput(Connection& connection);
+    void queueResponse(Connection& connection, MessageEncoding encoding, const nlohmann::json& response);  // Sent by the next flushOutput()
+    void closeClient(int fd);
+    void closeIdleClients();
+
+    // Subscriptions: each due stream is serialized once and fanned out to all its subscribers
+    nlohmann::json subscribe(Connection& connection, const std::string& stream, double rate);
+    void pushSubscriptions();
+    int nextPushTimeoutMs() const;
+    nlohmann::json buildStream(Stream stream);
+
+    // Forward target events to the client that set the target and to CONTROL_STATE subscribers
+    void dispatchTargetEvents();
+
+    // UDP telemetry endpoints of a connection
+    nlohmann::json udpSubscribe(Connection& connection, const nlohmann::json& request);
+    nlohmann::json udpUnsubscribe(Connection& connection);
+
+    // Switch the encoding of a connection, the acknowledgement still uses the former one
+    nlohmann::json setEncoding(Connection& connection, const std::string& encoding);
+
+    // Change the PID gains of one axis (fields not given are kept), always answers with all gains
+    nlohmann::json setGains(const nlohmann::json& request);
+
+    // Change several parameters at once and/or save them, always answers with all parameters
+    nlohmann::json handleParameters(const nlohmann::json& request);
+    void closeAll();
 
     // Handle incoming commands
-    std::string handleCommand(const std::string& command);
+    nlohmann::json handleCommand(Connection& connection, const std::string& command);
 
     // Helper methods to generate responses
-    std::string getTelemetry();
+    nlohmann::json getTelemetry();
 };
 
-#endif
\ No newline at end of file
+#endif // DRONE_CONNECTOR_H
\ No newline at end of file
@@ -1,22 +1,55 @@
 #include "ControlLoop.h"
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <math.h>
 #include <iostream>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 
-ControlLoop::ControlLoop(float k_lat, float k_lon, float k_alt, float k_yaw)
-    : k_lat(k_lat), k_lon(k_lon), k_alt(k_alt), k_yaw(k_yaw),
-      target_latitude(0.0), target_longitude(0.0), target_altitude(0.0), target_heading(0.0),
-      desired_speed(0.0), steering_signals({1024, 1024, 1024, 1024}), position_state(PositionControlState::REACHED) {}
+constexpr size_t ControlLoop::AXIS_COUNT;
+
+ControlLoop::ControlLoop(PositionSource &position_source, HeadingSource &heading_source)
+    : position_source(position_source), heading_source(heading_source), target_position({0.0, 0.0, 0.0f}), target_heading(0.0),
+      desired_speed(0.0), desired_altitude_speed(0.0), desired_yaw_speed(0.0), pid_time_ns(0), params_version(0),
+      steering_signals({1024, 1024, 1024, 1024}), tick_ns(0), target_start_ns(0), position_state(PositionControlState::REACHED),
+      start_position({0.0, 0.0, 0.0f}), start_heading(0.0),
+      mission_leg(0), holding(false), hold_start_ns(0), target_enu({0.0, 0.0, 0.0f}), temp_target(),
+      has_pending_target(false), last_target_id(0), active_target_id(0), target_event_count(0),
+      flight_recorder(nullptr), tick_flags(0), tick_errors(), sensors_stale(false) {
+    pending_target.waypoints.reserve(Mission::MAX_WAYPOINTS);
+    apply_parameters();
+}
+
+void ControlLoop::apply_parameters() {
+    uint64_t version = parameters.get_version();
+    if (version == params_version) return;
+    params_version = version;
+    params = parameters.get();
+
+    // The outputs may use the smaller side of the stick range
+    int output_limit = std::min(params.sbus_center - params.sbus_min, params.sbus_max - params.sbus_center);
+    for (size_t axis = 0; axis < AXIS_COUNT; ++axis) {
+        pid[axis].set_gains(params.gains[axis]);
+        pid[axis].set_output_limit(static_cast<float>(output_limit));
+    }
+}
 
 
 bool ControlLoop::init() {
-    return gps.init() && compass.init();
+    return position_source.init() && heading_source.init();
+}
+
+PositionSource &ControlLoop::get_position_source() {
+    return position_source;
 }
 
-bool ControlLoop::validate_target_parameters(float latitude, float longitude, float altitude, float heading, float speed, float altitude_speed, float yaw_speed) {
+HeadingSource &ControlLoop::get_heading_source() {
+    return heading_source;
+}
+
+bool ControlLoop::validate_target_parameters(double latitude, double longitude, float altitude, float heading, float speed, float altitude_speed, float yaw_speed) {
     
         // TODO: ...
 
@@ -27,176 +60,207 @@ bool ControlLoop::validate_target_parameters(float latitude, float longitude, fl
 }
 
 
-void ControlLoop::set_target(float latitude, float longitude, float altitude, float heading, float speed, float altitude_speed, float yaw_speed) {
-    std::lock_guard<std::mutex> lock(loop_mutex);
+uint32_t ControlLoop::set_target(double latitude, double longitude, float altitude, float heading, float speed, float altitude_speed, float yaw_speed) {
+    Waypoint waypoint = {{latitude, longitude, altitude}, heading, speed, altitude_speed, yaw_speed, 0.0f};
+    return set_mission(std::vector<Waypoint>(1, waypoint));
+}
 
-    bool valid = validate_target_parameters(latitude, longitude, altitude, heading, speed, altitude_speed, yaw_speed);
+uint32_t ControlLoop::set_mission(const std::vector<Waypoint> &waypoints) {
+    bool valid = !waypoints.empty() && waypoints.size() <= Mission::MAX_WAYPOINTS;
+    for (const Waypoint &waypoint : waypoints) {
+        valid = valid && validate_target_parameters(waypoint.position.latitude, waypoint.position.longitude,
+                                                    waypoint.position.altitude, waypoint.heading, waypoint.speed,
+                                                    waypoint.altitude_speed, waypoint.yaw_speed) &&
+                waypoint.hold_time >= 0.0f;
+    }
     if (!valid) {
-        position_state = PositionControlState::ABORTED;
+        // Rejected without a target id, an active or queued mission keeps going
         std::cerr << "Invalid target parameters!" << std::endl;
-        std::cout << "Position Control State: ABORTED" << std::endl;
-        return;
+        emit_target_event(0, PositionControlState::ABORTED, "invalid target parameters");
+        return 0;
+    }
+
+    // Only queue the mission here: waiting for GPS must not block the control tick or the SBUS output.
+    // The state changes under loop_mutex like in the tick (same lock order), so a tick that is just
+    // finishing a leg cannot overwrite PENDING afterwards.
+    std::lock_guard<std::mutex> loop_lock(loop_mutex);
+    std::lock_guard<std::mutex> lock(target_mutex);
+    // The mission replaces a queued or active one
+    if (has_pending_target) {
+        emit_target_event(pending_target.id, PositionControlState::ABORTED, "superseded");
+    } else if (position_state == PositionControlState::ACTIVE) {
+        emit_target_event(active_target_id, PositionControlState::ABORTED, "superseded");
     }
+    pending_target.id = ++last_target_id;
+    pending_target.waypoints.assign(waypoints.begin(), waypoints.end());   // Capacity is reserved
+    pending_target.deadline_ns = 0;     // Set by the first tick that sees it, in the tick's time base
+    has_pending_target = true;
+
+    position_state = PositionControlState::PENDING;
+    std::cout << "Position Control State: PENDING" << std::endl;
+    emit_target_event(pending_target.id, PositionControlState::PENDING, "waiting for reliable GPS");
+    return pending_target.id;
+}
 
-    constexpr int max_retries = 50; // 5 seconds with 100ms intervals
-    constexpr int retry_interval_ms = 100; // Retry every 100ms
-    // Retry loop to gain a GPS signal
-    bool reliable_data = false;
-    for (int i = 0; i < max_retries; ++i) {
-        gps.update();
+void ControlLoop::process_pending_target(int64_t now_ns, bool sensors_fresh, const GpsFix &fix) {
+    std::lock_guard<std::mutex> lock(target_mutex);
+    if (!has_pending_target) return;
+    if (pending_target.deadline_ns == 0) pending_target.deadline_ns = now_ns + params.target_gps_timeout_ms * 1000000LL;
 
-        if (gps.is_data_reliable()) {
-            reliable_data = true;
-            break;
-        }
-        std::this_thread::sleep_for(std::chrono::milliseconds(retry_interval_ms));
+    if (sensors_fresh && state_estimator.is_valid()) {
+        has_pending_target = false;
+        activate_mission(pending_target);
+        return;
     }
 
-    // Abort if GPS data is still not reliable after retries
-    if (!reliable_data) {
+    if (now_ns > pending_target.deadline_ns) {
+        has_pending_target = false;
         position_state = PositionControlState::ABORTED;
-        std::cerr << "Failed to acquire reliable GPS data within 5 seconds!" << std::endl;
-        std::cerr << "Fix quality: " << gps.get_fix_quality() << ", Satellites: " << gps.get_satellites() << std::endl;
+        std::cerr << "Failed to acquire reliable GPS data within " << params.target_gps_timeout_ms / 1000 << " seconds!" << std::endl;
+        std::cerr << "Fix quality: " << fix.fix_quality << ", Satellites: " << fix.satellites << std::endl;
         std::cout << "Position Control State: ABORTED" << std::endl;
-        return;
+        emit_target_event(pending_target.id, PositionControlState::ABORTED, "no reliable GPS");
     }
+}
 
-    // Proceed with setting the target
-    start_latitude = gps.get_latitude();
-    start_longitude = gps.get_longitude();
-    start_altitude = gps.get_altitude_agl();
-    start_heading = compass.get_heading();
-    target_start_time = std::chrono::steady_clock::now();
-
-    target_latitude = latitude;
-    target_longitude = longitude;
-    target_altitude = altitude;
-    target_heading = heading;
-    desired_speed = speed;
-    desired_altitude_speed = altitude_speed;
-    desired_yaw_speed = yaw_speed;
-
-    // Set temporary targets to starting positions
-    temp_target_latitude = start_latitude;
-    temp_target_longitude = start_longitude;
-    temp_target_altitude = start_altitude;
-    temp_target_heading = start_heading;
+void ControlLoop::activate_mission(TargetRequest &request) {
+    // Start from the estimated state, the same the control tick steers on. All legs are planned here,
+    // in a local East-North-Up frame at the start, the control loop works in meters from here on.
+    start_position = state_estimator.get_position();
+    mission.plan(request.waypoints, start_position, state_estimator.get_heading(), params.limits);
+    active_target_id = request.id;
 
+    start_leg(0);
+    pid_time_ns = 0;    // Fresh integrators for the new target
     position_state = PositionControlState::ACTIVE;
     std::cout << "Position Control State: ACTIVE" << std::endl;
+    emit_target_event(request.id, PositionControlState::ACTIVE, "target accepted", 0);
 }
 
+void ControlLoop::start_leg(size_t index) {
+    const MissionLeg &leg = mission.leg(index);
+    const Waypoint &waypoint = mission.waypoint(index);
+    mission_leg = index;
+    holding = false;
+    target_start_ns = tick_ns;
+
+    target_position = waypoint.position;
+    target_heading = waypoint.heading;
+    desired_speed = waypoint.speed;
+    desired_altitude_speed = waypoint.altitude_speed;
+    desired_yaw_speed = waypoint.yaw_speed;
+    start_heading = leg.start_heading;
+    target_enu = leg.end;
+
+    // Set temporary targets to the start of the leg
+    leg.trajectory.evaluate(0.0f, temp_target);
+}
 
-void ControlLoop::generate_temporary_target() {
-    // Calculate elapsed time in milliseconds
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - target_start_time).count();
-
-    // Convert elapsed time to seconds
-    float elapsed_time_s = elapsed_time_ms / 1000.0;
-
-    // Horizontal movement
-    float distance_to_travel = (desired_speed * 1000.0 / 3600.0) * elapsed_time_s;
-    float total_distance = calculate_distance(start_latitude, start_longitude, target_latitude, target_longitude);
-    if (distance_to_travel >= total_distance) {
-        // If the drone has (theoretically) reached or exceeded the target, set the temporary target as the final target
-        temp_target_latitude = target_latitude;
-        temp_target_longitude = target_longitude;
-    } else {
-        // Calculate the bearing from the starting position to the target
-        float target_bearing = calculate_bearing(start_latitude, start_longitude, target_latitude, target_longitude);
-        constexpr float R = 6371000.0; // Earth's radius in meters
-        float delta_lat = (distance_to_travel / R) * (180.0 / M_PI) * std::cos(target_bearing * M_PI / 180.0);
-        float delta_lon = (distance_to_travel / R) * (180.0 / M_PI) * std::sin(target_bearing * M_PI / 180.0) / std::cos(start_latitude * M_PI / 180.0);
-        temp_target_latitude = start_latitude + delta_lat;
-        temp_target_longitude = start_longitude + delta_lon;
-    }
-
-    // Altitude movement
-    float altitude_to_climb = elapsed_time_s * (desired_altitude_speed * 1000.0 / 3600.0);
-    if (target_altitude < start_altitude) {
-        // sink to target altitude
-        temp_target_altitude = std::max(start_altitude - altitude_to_climb, target_altitude);
-    }
-    else {
-        // climb to target altitude
-        temp_target_altitude = std::min(start_altitude + altitude_to_climb, target_altitude);
-    }
+void ControlLoop::emit_target_event(uint32_t target_id, PositionControlState state, const char *reason, int waypoint) {
+    std::lock_guard<std::mutex> lock(event_mutex);
+    TargetEvent &event = target_events[target_event_count % TARGET_EVENT_CAPACITY];
+    event.sequence = ++target_event_count;
+    event.target_id = target_id;
+    event.state = state;
+    event.reason = reason;
+    event.waypoint = waypoint;
+    event.timestamp_ns = monotonic_ns();
+    if (event_listener) event_listener();
+}
 
-    // Heading movement
-    float heading_to_rotate = elapsed_time_s * desired_yaw_speed;
-    float clockwiseAngle, counterClockwiseAngle;
-    clockwiseAngle = fmod(target_heading - start_heading + 360.0, 360.0);
-    counterClockwiseAngle = fmod(start_heading - target_heading + 360.0, 360.0);
-    if (clockwiseAngle <= counterClockwiseAngle) {
-        // Rotate clockwise
-        temp_target_heading = start_heading + heading_to_rotate;
-        // Adjust the target heading to the range [start_heading, start_heading + 360)
-        float adjusted_target_heading = target_heading;
-        if (target_heading < start_heading) {
-            adjusted_target_heading += 360.0;
-        }
-        // Stop at the target if overshooting
-        if (temp_target_heading > adjusted_target_heading) {
-            temp_target_heading = adjusted_target_heading;
-        }
-        temp_target_heading = fmod(temp_target_heading, 360.0);
-    } else {
-        // Rotate counter-clockwise
-        temp_target_heading = start_heading - heading_to_rotate;
-        // Adjust the target heading to the range [start_heading - 360, start_heading)
-        float adjusted_target_heading = target_heading;
-        if (target_heading > start_heading) {
-            adjusted_target_heading -= 360.0;
-        }
-        // Stop at the target if overshooting
-        if (temp_target_heading < adjusted_target_heading) {
-            temp_target_heading = adjusted_target_heading;
-        }
-        temp_target_heading = fmod(temp_target_heading + 360.0, 360.0);  // Normalize to [0, 360)
+void ControlLoop::get_target_events(uint64_t &cursor, std::vector<TargetEvent> &events) {
+    std::lock_guard<std::mutex> lock(event_mutex);
+    if (target_event_count - cursor > TARGET_EVENT_CAPACITY) cursor = target_event_count - TARGET_EVENT_CAPACITY;
+    for (; cursor < target_event_count; ++cursor) {
+        events.push_back(target_events[cursor % TARGET_EVENT_CAPACITY]);
     }
-    
-    // std::cout << "lat: " << temp_target_latitude << ", lon: " << temp_target_longitude 
-    //         << ", alt: " << temp_target_altitude << ", head:" << temp_target_heading << std::endl;
 }
 
+uint64_t ControlLoop::get_target_event_count() {
+    std::lock_guard<std::mutex> lock(event_mutex);
+    return target_event_count;
+}
 
+void ControlLoop::set_event_listener(std::function<void()> listener) {
+    std::lock_guard<std::mutex> lock(event_mutex);
+    event_listener = listener;
+}
 
-int ControlLoop::constrain(int value, int min_value, int max_value) {
-    return std::max(min_value, std::min(value, max_value));
+const char *ControlLoop::state_name(PositionControlState state) {
+    switch (state) {
+        case PositionControlState::REACHED: return "REACHED";
+        case PositionControlState::ACTIVE: return "ACTIVE";
+        case PositionControlState::ABORTED: return "ABORTED";
+        case PositionControlState::PENDING: return "PENDING";
+    }
+    return "UNKNOWN";
 }
 
-float ControlLoop::calculate_distance(float lat1, float lon1, float lat2, float lon2) {
-    constexpr float R = 6371000.0; // Earth's radius in meters
-    float dlat = (lat2 - lat1) * M_PI / 180.0;
-    float dlon = (lon2 - lon1) * M_PI / 180.0;
 
-    float a = std::sin(dlat / 2) * std::sin(dlat / 2) +
-              std::cos(lat1 * M_PI / 180.0) * std::cos(lat2 * M_PI / 180.0) *
-                  std::sin(dlon / 2) * std::sin(dlon / 2);
-    float c = 2 * std::atan2(std::sqrt(a), std::sqrt(1 - a));
+void ControlLoop::generate_temporary_target() {
+    const MissionLeg &leg = mission.leg(mission_leg);
+    if (holding) {
+        // Hold the waypoint itself, even if it was reached before the temporary target got there
+        temp_target.position = leg.end;
+        temp_target.heading = leg.end_heading;
+        temp_target.velocity_east = temp_target.velocity_north = temp_target.climb_rate = temp_target.yaw_rate = 0.0f;
+        return;
+    }
+
+    // The leg was compiled into a parametric trajectory when the mission was planned
+    float elapsed_time_s = (tick_ns - target_start_ns) * 1e-9f;
+    leg.trajectory.evaluate(elapsed_time_s, temp_target);
 
-    return R * c; // Distance in meters
+    // std::cout << "east: " << temp_target.position.east << ", north: " << temp_target.position.north
+    //         << ", up: " << temp_target.position.up << ", head:" << temp_target.heading << std::endl;
 }
 
-float ControlLoop::calculate_bearing(float lat1, float lon1, float lat2, float lon2) {
-    float dlon = (lon2 - lon1) * M_PI / 180.0;
-    lat1 = lat1 * M_PI / 180.0;
-    lat2 = lat2 * M_PI / 180.0;
 
-    float y = std::sin(dlon) * std::cos(lat2);
-    float x = std::cos(lat1) * std::sin(lat2) - std::sin(lat1) * std::cos(lat2) * std::cos(dlon);
 
-    float bearing = std::atan2(y, x) * 180.0 / M_PI;
-    return fmod(bearing + 360.0, 360.0); // Normalize to [0, 360]
+int ControlLoop::constrain(int value, int min_value, int max_value) {
+    return std::max(min_value, std::min(value, max_value));
 }
 
 void ControlLoop::update_signals() {
+    // Take one snapshot per sensor for the whole tick
+    position_source.update();
+    int64_t now_ns = monotonic_ns();
+    update_signals(position_source.get_fix_sample(), heading_source.get_sample(), now_ns);
+}
+
+void ControlLoop::update_signals(const Sample<GpsFix> &gps_sample, const Sample<CompassSample> &compass_sample, int64_t now_ns) {
     std::lock_guard<std::mutex> lock(loop_mutex);
-    
+    if (flight_recorder == nullptr) {
+        run_tick(gps_sample, compass_sample, now_ns);
+        return;
+    }
+
+    int64_t start_ns = monotonic_ns();
+    run_tick(gps_sample, compass_sample, now_ns);
+    record_tick(gps_sample, compass_sample, now_ns, monotonic_ns() - start_ns);
+}
+
+void ControlLoop::run_tick(const Sample<GpsFix> &gps_sample, const Sample<CompassSample> &compass_sample, int64_t now_ns) {
+    apply_parameters();
+    tick_ns = now_ns;
+    tick_flags = 0;
+    tick_errors.fill(0.0f);
+
+    // Check how old the data is
+    int64_t gps_age_us = gps_sample.sequence > 0 ? (now_ns - gps_sample.timestamp_ns) / 1000 : -1;
+    int64_t compass_age_us = compass_sample.sequence > 0 ? (now_ns - compass_sample.timestamp_ns) / 1000 : -1;
+    bool gps_stale = gps_age_us < 0 || gps_age_us > params.gps_max_age_ms * 1000;
+    bool compass_stale = compass_age_us < 0 || compass_age_us > params.compass_max_age_ms * 1000;
+    gps_age.record(gps_age_us, gps_stale);
+    compass_age.record(compass_age_us, compass_stale);
+    if (gps_stale) tick_flags |= FlightRecord::FLAG_GPS_STALE;
+    if (compass_stale) tick_flags |= FlightRecord::FLAG_COMPASS_STALE;
+    state_estimator.update(gps_sample, compass_sample, now_ns);
+    process_pending_target(now_ns, !gps_stale && !compass_stale, gps_sample.value);
+
     // Check the position control state
     if (position_state != PositionControlState::ACTIVE) {
-        steering_signals = {1024, 1024, 1024, 1024}; // Default neutral signals
+        steering_signals.fill(params.sbus_center); // Default neutral signals
     //     if (position_state == PositionControlState::ABORTED) {
     //         std::cout << "Position Control State: ABORTED" << std::endl;
     //     }
@@ -206,71 +270,174 @@ void ControlLoop::update_signals() {
         return;
     }
 
-    gps.update();
-    if (!gps.is_data_reliable()) {
-        std::cerr << "GPS data not reliable! Fix quality: " << gps.get_fix_quality() << ", Satellites: " << gps.get_satellites() << std::endl;
+    // Never steer on old data: hold position until fresh samples arrive
+    if (gps_stale || compass_stale) {
+        steering_signals.fill(params.sbus_center); // Default neutral signals
+        if (!sensors_stale) {
+            std::cerr << "Stale sensor data! GPS age: " << gps_age_us / 1000 << " ms, compass age: "
+                      << compass_age_us / 1000 << " ms" << std::endl;
+        }
+        sensors_stale = true;
         return;
     }
+    if (sensors_stale) {
+        std::cout << "Sensor data fresh again" << std::endl;
+        sensors_stale = false;
+    }
 
-    float current_latitude = gps.get_latitude();
-    float current_longitude = gps.get_longitude();
-    float current_altitude = gps.get_altitude_agl();
-    float current_heading = compass.get_heading();
+    const GpsFix &fix = gps_sample.value;
+    if (!fix.is_reliable()) {
+        std::cerr << "GPS data not reliable! Fix quality: " << fix.fix_quality << ", Satellites: " << fix.satellites << std::endl;
+        return;
+    }
 
-    // Check if the target is reached
-    if (is_target_reached(current_latitude, current_longitude, current_altitude, current_heading)) {
-        position_state = PositionControlState::REACHED;
-        steering_signals = {1024, 1024, 1024, 1024}; // Default neutral signals
-        std::cout << "Position Control State: REACHED" << std::endl;
+    if (!state_estimator.is_valid()) {
+        steering_signals.fill(params.sbus_center); // Default neutral signals
         return;
     }
 
+    // Estimated state: filtered against sensor noise and dead reckoned between GPS fixes, so the
+    // controller sees neither noise nor 1-10 Hz position steps
+    EnuPoint current_enu = mission.frame().to_enu(state_estimator.get_position());
+    float current_heading = state_estimator.get_heading();
+
+    // Check if the waypoint is reached, the last one ends the mission
+    if (!holding && is_target_reached(current_enu, current_heading)) {
+        if (mission_leg + 1 >= mission.size()) {
+            position_state = PositionControlState::REACHED;
+            steering_signals.fill(params.sbus_center); // Default neutral signals
+            std::cout << "Position Control State: REACHED" << std::endl;
+            emit_target_event(active_target_id, PositionControlState::REACHED, "target reached", static_cast<int>(mission_leg));
+            return;
+        }
+        holding = true;
+        hold_start_ns = now_ns;
+        std::cout << "Waypoint " << mission_leg << " reached" << std::endl;
+        emit_target_event(active_target_id, PositionControlState::ACTIVE, "waypoint reached", static_cast<int>(mission_leg));
+    }
+
+    // Keep steering onto the waypoint for its hold time, then start the next leg
+    if (holding) {
+        float held_s = (now_ns - hold_start_ns) * 1e-9f;
+        if (held_s >= mission.waypoint(mission_leg).hold_time) start_leg(mission_leg + 1);
+    }
+
+    if (holding) tick_flags |= FlightRecord::FLAG_HOLDING;
+
     // Generate the temporary target
     generate_temporary_target();
 
     // Calculate errors based on the temporary target
-    float distance_error = calculate_distance(current_latitude, current_longitude, temp_target_latitude, temp_target_longitude);
-    float altitude_error = temp_target_altitude - current_altitude;
-    float target_bearing = calculate_bearing(current_latitude, current_longitude, temp_target_latitude, temp_target_longitude);
-    float heading_error = temp_target_heading - current_heading;
+    float east_error = temp_target.position.east - current_enu.east;
+    float north_error = temp_target.position.north - current_enu.north;
+    float altitude_error = temp_target.position.up - current_enu.up;
+    float heading_error = temp_target.heading - current_heading;
 
     if (heading_error > 180.0) heading_error -= 360.0;
     if (heading_error < -180.0) heading_error += 360.0;
 
-    // Calculate relative bearing (target bearing relative to current heading)
-    float relative_bearing = target_bearing - current_heading;
-    if (relative_bearing > 180.0) relative_bearing -= 360.0;
-    if (relative_bearing < -180.0) relative_bearing += 360.0;
+    // Rotate the horizontal error, the measured velocity and the target velocity into the body frame of the drone
+    EstimatedState estimate = state_estimator.get_state();
+    float heading_rad = current_heading * M_PI / 180.0;
+    float cos_heading = std::cos(heading_rad);
+    float sin_heading = std::sin(heading_rad);
+    float forward_error = north_error * cos_heading + east_error * sin_heading;
+    float lateral_error = east_error * cos_heading - north_error * sin_heading;
+    float forward_velocity = estimate.velocity_north * cos_heading + estimate.velocity_east * sin_heading;
+    float lateral_velocity = estimate.velocity_east * cos_heading - estimate.velocity_north * sin_heading;
+    float forward_setpoint = temp_target.velocity_north * cos_heading + temp_target.velocity_east * sin_heading;
+    float lateral_setpoint = temp_target.velocity_east * cos_heading - temp_target.velocity_north * sin_heading;
+
+    // Restart the controllers after a gap (new target, stale sensors), the integrators would be outdated
+    float dt = (now_ns - pid_time_ns) * 1e-9f;
+    if (pid_time_ns == 0 || now_ns - pid_time_ns > PID_MAX_GAP_MS * 1000000) {
+        for (PidController &controller : pid) controller.reset();
+        dt = 0.0f;
+    }
+    pid_time_ns = now_ns;
+
+    // Error, measured rate and target rate per axis, in ControlAxis order (the SBUS channel order):
+    // left-right, front-back, up-down, CW-CCW rotation
+    const float errors[AXIS_COUNT] = {lateral_error, forward_error, altitude_error, heading_error};
+    const float measured_rates[AXIS_COUNT] = {lateral_velocity, forward_velocity, estimate.climb_rate, estimate.yaw_rate};
+    const float setpoint_rates[AXIS_COUNT] = {lateral_setpoint, forward_setpoint, temp_target.climb_rate, temp_target.yaw_rate};
 
-    // Normalize the relative bearing into components
-    float forward_component = std::cos(relative_bearing * M_PI / 180.0);
-    float lateral_component = std::sin(relative_bearing * M_PI / 180.0);
+    std::copy(errors, errors + AXIS_COUNT, tick_errors.begin());
+    tick_flags |= FlightRecord::FLAG_STEERING;
 
-     // Generate steering signals
-    steering_signals[0] = constrain(1024 + static_cast<int>(k_lat * distance_error * lateral_component), 364, 1684); // Left-right
-    steering_signals[1] = constrain(1024 + static_cast<int>(k_lon * distance_error * forward_component), 364, 1684); // Front-back
-    steering_signals[2] = constrain(1024 + static_cast<int>(k_alt * altitude_error), 364, 1684); // Up-down
-    steering_signals[3] = constrain(1024 + static_cast<int>(k_yaw * heading_error), 364, 1684); // CW-CCW rotation
+    // Generate steering signals
+    for (size_t axis = 0; axis < AXIS_COUNT; ++axis) {
+        float output = pid[axis].update(errors[axis], measured_rates[axis], setpoint_rates[axis], dt);
+        steering_signals[axis] = constrain(params.sbus_center + static_cast<int>(output), params.sbus_min, params.sbus_max);
+    }
 
     
-    // std::cout << "e_dist: " << distance_error << ", x: " << steering_signals[0] << ", y: " << steering_signals[1]
+    // std::cout << "e_fwd: " << forward_error << ", e_lat: " << lateral_error << ", x: " << steering_signals[0] << ", y: " << steering_signals[1]
     //         << ", e_alt: " << altitude_error << ", z: " << steering_signals[2]
     //         << ", e_head: " << heading_error << ", phi: " << steering_signals[3] 
-    //         << ", bearing: " << relative_bearing 
-            // << ", t_loc: " << temp_target_latitude << ", " << temp_target_longitude 
-            // << ", t_glob: " << target_latitude << ", " << target_longitude 
-            // << ", cur_pos: " << current_latitude << ", " << current_longitude 
+            // << ", t_loc: " << temp_target.position.east << ", " << temp_target.position.north
+            // << ", t_glob: " << target_enu.east << ", " << target_enu.north 
+            // << ", cur_pos: " << current_enu.east << ", " << current_enu.north 
             // << std::endl;
 }
 
-bool ControlLoop::is_target_reached(float current_latitude, float current_longitude, float current_altitude, float current_heading) {
-    float distance_error = calculate_distance(current_latitude, current_longitude, target_latitude, target_longitude);
-    float altitude_error = target_altitude - current_altitude;
+void ControlLoop::record_tick(const Sample<GpsFix> &gps_sample, const Sample<CompassSample> &compass_sample, int64_t now_ns, int64_t duration_ns) {
+    FlightRecord record;
+    memset(&record, 0, sizeof(record));
+    record.tick_ns = now_ns;
+    record.duration_ns = static_cast<uint32_t>(std::min<int64_t>(duration_ns, UINT32_MAX));
+    record.target_id = active_target_id;
+    record.state = static_cast<uint8_t>(position_state.load());
+    record.flags = tick_flags;
+    record.mission_leg = static_cast<uint16_t>(mission_leg);
+
+    const GpsFix &fix = gps_sample.value;
+    record.gps_latitude = fix.latitude;
+    record.gps_longitude = fix.longitude;
+    record.gps_altitude = fix.altitude_agl;
+    record.gps_speed = fix.speed;
+    record.gps_course = fix.course;
+    record.gps_age_us = gps_sample.sequence > 0 ? static_cast<int32_t>((now_ns - gps_sample.timestamp_ns) / 1000) : -1;
+    record.gps_fix_quality = static_cast<uint8_t>(fix.fix_quality);
+    record.gps_satellites = static_cast<uint8_t>(fix.satellites);
+    record.compass_heading = compass_sample.value.heading;
+    record.compass_age_us = compass_sample.sequence > 0 ? static_cast<int32_t>((now_ns - compass_sample.timestamp_ns) / 1000) : -1;
+
+    EstimatedState estimate = state_estimator.get_state();
+    record.estimate_latitude = estimate.position.latitude;
+    record.estimate_longitude = estimate.position.longitude;
+    record.estimate_altitude = estimate.position.altitude;
+    record.estimate_heading = estimate.heading;
+    record.estimate_velocity_east = estimate.velocity_east;
+    record.estimate_velocity_north = estimate.velocity_north;
+    record.estimate_climb_rate = estimate.climb_rate;
+    record.estimate_yaw_rate = estimate.yaw_rate;
+
+    record.target_east = static_cast<float>(temp_target.position.east);
+    record.target_north = static_cast<float>(temp_target.position.north);
+    record.target_up = temp_target.position.up;
+    record.target_heading = temp_target.heading;
+    std::copy(tick_errors.begin(), tick_errors.end(), record.errors);
+    std::copy(steering_signals.begin(), steering_signals.end(), record.channels);
+
+    flight_recorder->append(record);
+}
+
+void ControlLoop::set_flight_recorder(FlightRecorder *recorder) {
+    std::lock_guard<std::mutex> lock(loop_mutex);
+    flight_recorder = recorder;
+}
+
+bool ControlLoop::is_target_reached(const EnuPoint &current_enu, float current_heading) {
+    double east_error = target_enu.east - current_enu.east;
+    double north_error = target_enu.north - current_enu.north;
+    double distance_error = std::sqrt(east_error * east_error + north_error * north_error);
+    float altitude_error = target_enu.up - current_enu.up;
     float heading_error = target_heading - current_heading;
 
-    if (std::abs(distance_error) <= DISTANCE_THRESHOLD &&
-        std::abs(altitude_error) <= ALTITUDE_THRESHOLD &&
-        std::abs(heading_error) <= HEADING_THRESHOLD) {
+    if (std::abs(distance_error) <= params.distance_threshold &&
+        std::abs(altitude_error) <= params.altitude_threshold &&
+        std::abs(heading_error) <= params.heading_threshold) {
         return true;
     }
     return false;
@@ -278,9 +445,17 @@ bool ControlLoop::is_target_reached(float current_latitude, float current_longit
 
 void ControlLoop::abort() {
     std::lock_guard<std::mutex> lock(loop_mutex);
+    uint32_t target_id = active_target_id;
+    {
+        // A queued target is dropped as well
+        std::lock_guard<std::mutex> target_lock(target_mutex);
+        if (has_pending_target) target_id = pending_target.id;
+        has_pending_target = false;
+    }
     if (position_state != PositionControlState::ABORTED) {
         position_state = PositionControlState::ABORTED;
         std::cout << "Position Control aborted" << std::endl;
+        emit_target_event(target_id, PositionControlState::ABORTED, "aborted");
     }
 }
 
@@ -307,12 +482,13 @@ sbus_packet_t ControlLoop::get_steering_signals() {
     }
     else {
         // Don't move if state is aborted or reached:
+        uint16_t neutral = static_cast<uint16_t>(params.sbus_center);
         sbus_packet_t packet = {
             .channels = {
-                1024,     // Roll (left - right)
-                1024,     // Pitch (back - front)
-                1024,     // Throttle (down - up)
-                1024,     // Yaw (counter-clockwise - clockwise)
+                neutral,     // Roll (left - right)
+                neutral,     // Pitch (back - front)
+                neutral,     // Throttle (down - up)
+                neutral,     // Yaw (counter-clockwise - clockwise)
                 1684,           // Ch: 5 (not used)
                 1541,           // Orientation Mode: OFF (1024 = Course Lock, 511 = Home Lock)
                 1541,           // Flight Mode: Hold GPS Position (511 = Manual, 1024 = Hold altitude)
@@ -327,35 +503,90 @@ sbus_packet_t ControlLoop::get_steering_signals() {
     }
 }
 
+const StateEstimator &ControlLoop::get_state_estimator() const {
+    return state_estimator;
+}
+
+const AgeHistogram &ControlLoop::get_gps_age() const {
+    return gps_age;
+}
+
+const AgeHistogram &ControlLoop::get_compass_age() const {
+    return compass_age;
+}
+
 ControlLoop::PositionControlState ControlLoop::get_position_control_state() const {
     return position_state.load(); // Ensure thread-safe access
 }
 
 std::string ControlLoop::get_json_state(){
+    return get_state_json().dump(); // Serialize JSON to a string
+}
+
+json ControlLoop::get_state_json(){
     std::lock_guard<std::mutex> lock(loop_mutex); // Ensure thread safety
+    GeoPosition temp_target_position = mission.frame().to_geodetic(temp_target.position);
     json state = {
         {"type", "CONTROL_STATE"},
         {"control_loop_state", static_cast<int>(position_state.load())},
+        {"target_id", active_target_id.load()},
         {"target",
             {
-                {"lat", target_latitude},
-                {"long", target_longitude},
-                {"altitude", target_altitude},
+                {"lat", target_position.latitude},
+                {"long", target_position.longitude},
+                {"altitude", target_position.altitude},
                 {"heading", target_heading},
             }
         },
         {"temp_target",
             {
-                {"lat", temp_target_latitude},
-                {"lon", temp_target_longitude},
-                {"altitude", temp_target_altitude},
-                {"heading", temp_target_heading},
+                {"lat", temp_target_position.latitude},
+                {"lon", temp_target_position.longitude},
+                {"altitude", temp_target_position.altitude},
+                {"heading", temp_target.heading},
+            }
+        },
+        {"mission",
+            {
+                {"waypoint", mission_leg},
+                {"waypoints", mission.size()},
+                {"holding", holding}
             }
         },
         {"desired_speed", desired_speed},
         {"desired_altitude_speed", desired_altitude_speed},
         {"desired_yaw_speed", desired_yaw_speed},
     };
+    for (size_t axis = 0; axis < AXIS_COUNT; ++axis) {
+        state["pid"][axis_name(static_cast<ControlAxis>(axis))] = {
+            {"integral", pid[axis].get_integral()},
+            {"output", pid[axis].get_output()}
+        };
+    }
+
+    return state;
+}
+
+ParameterStore &ControlLoop::get_parameters() {
+    return parameters;
+}
 
-    return state.dump(); // Serialize JSON to a string
+const char *ControlLoop::axis_name(ControlAxis axis) {
+    switch (axis) {
+        case ControlAxis::ROLL: return "ROLL";
+        case ControlAxis::PITCH: return "PITCH";
+        case ControlAxis::THROTTLE: return "THROTTLE";
+        case ControlAxis::YAW: return "YAW";
+    }
+    return "UNKNOWN";
+}
+
+bool ControlLoop::parse_axis(const std::string &name, ControlAxis &axis) {
+    for (size_t index = 0; index < AXIS_COUNT; ++index) {
+        if (name == axis_name(static_cast<ControlAxis>(index))) {
+            axis = static_cast<ControlAxis>(index);
+            return true;
+        }
+    }
+    return false;
 }
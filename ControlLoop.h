@@ -1,30 +1,84 @@
 #ifndef DRONE_CONTROL_LOOP_H
 #define DRONE_CONTROL_LOOP_H
 
-#include "GPSModule.h"
-#include "Compass.h"
+#include "SensorInterfaces.h"
+#include "Geodesy.h"
+#include "SensorAge.h"
+#include "StateEstimator.h"
+#include "Mission.h"
+#include "PidController.h"
+#include "ParameterStore.h"
+#include "FlightRecorder.h"
 #include <array>
 #include <mutex>
 #include <chrono>
 #include <atomic>
+#include <functional>
+#include <vector>
 #include "SBUS.h"
+#include <nlohmann/json_fwd.hpp>
 
 class ControlLoop {
 
 public:
-    enum class PositionControlState { REACHED, ACTIVE, ABORTED };
-    
-    GPS gps;
-    Compass compass;
-    ControlLoop(float k_lat, float k_lon, float k_alt, float k_yaw);
+    enum class PositionControlState { REACHED, ACTIVE, ABORTED, PENDING };
 
-    // Set target parameters
-    void set_target(float latitude, float longitude, float altitude, float heading, float speed, float altitude_speed, float yaw_speed);
+    // Controlled axes, in the order of the SBUS channels
+    enum class ControlAxis { ROLL, PITCH, THROTTLE, YAW };
+    static constexpr size_t AXIS_COUNT = 4;
+
+    // Change of the position control state, in the order they happened
+    struct TargetEvent {
+        uint64_t sequence;          // 1 for the first event
+        uint32_t target_id;         // Target the event belongs to, 0 if none
+        PositionControlState state;
+        const char *reason;         // Static string
+        int waypoint;               // Mission waypoint the event refers to, -1 if none
+        int64_t timestamp_ns;       // monotonic_ns()
+    };
+
+    // Steers on the fixes of <position_source> and the heading of <heading_source>, e.g. GPS and Compass
+    ControlLoop(PositionSource &position_source, HeadingSource &heading_source);
+
+    // Queue a new target and return immediately. The control loop activates it on its next tick with
+    // reliable GPS, or aborts it after the target.gps_timeout_ms parameter. Returns the target id, 0 if the
+    // parameters are invalid. The outcome is reported as TargetEvent.
+    uint32_t set_target(double latitude, double longitude, float altitude, float heading, float speed, float altitude_speed, float yaw_speed);
+
+    // Queue a mission of up to Mission::MAX_WAYPOINTS waypoints, flown in order like a sequence of targets.
+    // Each waypoint is held for its hold time before the next leg starts. Returns the target id, 0 if invalid.
+    uint32_t set_mission(const std::vector<Waypoint> &waypoints);
+
+    // Events after <cursor> (an event sequence number), cursor is advanced to the last returned event.
+    // Only the latest TARGET_EVENT_CAPACITY events are kept.
+    void get_target_events(uint64_t &cursor, std::vector<TargetEvent> &events);
+    uint64_t get_target_event_count();
+
+    // Called from the thread that emitted a target event, keep it short (e.g. wake up another thread)
+    void set_event_listener(std::function<void()> listener);
+
+    static const char *state_name(PositionControlState state);
+
+    // Gains, thresholds, limits and channel constants. Changes apply from the next control tick on.
+    // The PID gains of roll and pitch act on the horizontal error in meters, throttle on the altitude
+    // error in meters, yaw on the heading error in degrees; outputs are SBUS steps from the channel center.
+    ParameterStore &get_parameters();
+
+    static const char *axis_name(ControlAxis axis);
+    static bool parse_axis(const std::string &name, ControlAxis &axis);
 
 
     // Compute steering signals based on current state and target
     void update_signals();
 
+    // One control tick on the given sensor samples at <now_ns>. update_signals() calls it with the
+    // latest samples of the sources and the monotonic_ns() time; a simulation passes its own
+    // samples and time. The control loop itself only reads the clock to time ticks for the flight recorder.
+    void update_signals(const Sample<GpsFix> &gps_sample, const Sample<CompassSample> &compass_sample, int64_t now_ns);
+
+    // Append every control tick to <recorder>, nullptr stops recording
+    void set_flight_recorder(FlightRecorder *recorder);
+
     // Get the current steering signals
     sbus_packet_t get_steering_signals();
 
@@ -34,59 +88,103 @@ public:
     // Get current position control state
     PositionControlState get_position_control_state() const;
     std::string get_json_state();
+    nlohmann::json get_state_json();
 
-    // Initialize GPS and Compass
+    // Initialize the position and heading sources
     bool init();
 
+    PositionSource &get_position_source();
+    HeadingSource &get_heading_source();
+
+    // Ages of the sensor samples the control loop used
+    const AgeHistogram &get_gps_age() const;
+    const AgeHistogram &get_compass_age() const;
+
+    // Fused GPS/compass state used for control, dead reckoned between GPS fixes
+    const StateEstimator &get_state_estimator() const;
+
 private:
+    PositionSource &position_source;
+    HeadingSource &heading_source;
+
     // Target parameters
-    float target_latitude;
-    float target_longitude;
-    float target_altitude;
+    GeoPosition target_position;
     float target_heading; // In degrees
     float desired_speed;  // In km/h
     float desired_altitude_speed; // Altitude climbing speed (km/h)
     float desired_yaw_speed;      // Yaw rotation speed (degrees/s)
-    float temp_target_latitude;  // Temporary target latitude
-    float temp_target_longitude; // Temporary target longitude
-    float temp_target_altitude;
-    float temp_target_heading;
 
-    // Control parameters
-    float k_lat; // Proportional gain for lateral (left-right)
-    float k_lon; // Proportional gain for longitudinal (front-back)
-    float k_alt; // Proportional gain for altitude (up-down)
-    float k_yaw; // Proportional gain for yaw (rotation)
+    // One PID per SBUS channel, indexed by ControlAxis
+    std::array<PidController, AXIS_COUNT> pid;
+    int64_t pid_time_ns;        // Time of the last PID step, 0 to restart the controllers
+    static constexpr int64_t PID_MAX_GAP_MS = 500;      // Longer gaps restart the controllers
+
+    // Parameters in use, replaced by the latest snapshot of the store at the start of a tick
+    ParameterStore parameters;
+    ControlParameters params;
+    uint64_t params_version;
+    void apply_parameters();
 
     std::array<uint16_t, 4> steering_signals; // Output signals for the drone
     std::mutex loop_mutex;               // Protect shared data
-    std::chrono::steady_clock::time_point target_start_time;
+    int64_t tick_ns;            // Time of the current control tick
+    int64_t target_start_ns;    // Start of the current leg
     std::atomic<PositionControlState> position_state;
-    float start_latitude;   // Latitude at the time the target was set
-    float start_longitude;  // Longitude at the time the target was set
-    float start_altitude;   // Altitude at the time the target was set
-    float start_heading;    // Heading at the time the target was set
-
-    // Thresholds for determining if the target is reached
-    static constexpr float DISTANCE_THRESHOLD = 2.0;  // Meters
-    static constexpr float ALTITUDE_THRESHOLD = 5.0; // Meters
-    static constexpr float HEADING_THRESHOLD = 5.0;  // Degrees
-
-
-    bool validate_target_parameters(float latitude, float longitude, float altitude, float heading, float speed, float altitude_speed, float yaw_speed);
+    GeoPosition start_position; // Position at the time the mission started
+    float start_heading;        // Heading at the start of the current leg
+
+    // Active mission, planned in a local East-North-Up frame anchored at the start position
+    Mission mission;
+    size_t mission_leg;         // Leg flown towards waypoint <mission_leg>
+    bool holding;               // Waypoint reached, holding it until its hold time is over
+    int64_t hold_start_ns;
+    EnuPoint target_enu;        // Current waypoint in the mission frame
+    TrajectorySample temp_target;   // Temporary target moving from the start to the end of the leg (in the mission frame)
+
+    // Queued mission, handed from set_mission() to the control tick
+    struct TargetRequest {
+        uint32_t id;
+        std::vector<Waypoint> waypoints;    // Reserved for Mission::MAX_WAYPOINTS
+        int64_t deadline_ns;    // Aborted if GPS is not reliable until then, 0 until the first tick
+    };
+    std::mutex target_mutex;    // Protects the pending target, never held for long
+    TargetRequest pending_target;
+    bool has_pending_target;
+    uint32_t last_target_id;
+    std::atomic<uint32_t> active_target_id;
+
+    static constexpr size_t TARGET_EVENT_CAPACITY = 16;
+    std::mutex event_mutex;     // Protects the event ring and the listener
+    TargetEvent target_events[TARGET_EVENT_CAPACITY];
+    uint64_t target_event_count;
+    std::function<void()> event_listener;
+
+    // Flight recording, the tick leaves what it computed in the tick_ members
+    FlightRecorder *flight_recorder;
+    uint8_t tick_flags;         // FlightRecord::FLAG_*
+    std::array<float, AXIS_COUNT> tick_errors;
+    void run_tick(const Sample<GpsFix> &gps_sample, const Sample<CompassSample> &compass_sample, int64_t now_ns);
+    void record_tick(const Sample<GpsFix> &gps_sample, const Sample<CompassSample> &compass_sample, int64_t now_ns, int64_t duration_ns);
+
+    void process_pending_target(int64_t now_ns, bool sensors_fresh, const GpsFix &fix);
+    void activate_mission(TargetRequest &request);
+    void start_leg(size_t index);
+    void emit_target_event(uint32_t target_id, PositionControlState state, const char *reason, int waypoint = -1);
+
+    StateEstimator state_estimator;
+    AgeHistogram gps_age;
+    AgeHistogram compass_age;
+    bool sensors_stale;         // Stale data was rejected in the last tick
+
+
+    bool validate_target_parameters(double latitude, double longitude, float altitude, float heading, float speed, float altitude_speed, float yaw_speed);
 
     void generate_temporary_target();
 
     // Utility function to constrain a value
     int constrain(int value, int min_value, int max_value);
 
-    // Utility function to calculate distance between two GPS points (Haversine formula)
-    float calculate_distance(float lat1, float lon1, float lat2, float lon2);
-
-    // Utility function to calculate bearing between two GPS points
-    float calculate_bearing(float lat1, float lon1, float lat2, float lon2);
-
-    bool is_target_reached(float current_latitude, float current_longitude, float current_altitude, float current_heading);
+    bool is_target_reached(const EnuPoint &current_enu, float current_heading);
 };
 
 #endif // CONTROL_LOOP_H
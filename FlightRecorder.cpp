@@ -0,0 +1,201 @@
+#include "FlightRecorder.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+constexpr uint8_t FlightRecord::FLAG_GPS_STALE;
+constexpr uint8_t FlightRecord::FLAG_COMPASS_STALE;
+constexpr uint8_t FlightRecord::FLAG_STEERING;
+constexpr uint8_t FlightRecord::FLAG_HOLDING;
+constexpr size_t FlightRecorder::DEFAULT_CAPACITY;
+
+static_assert(sizeof(FlightRecord) == 160, "FlightRecord layout is part of the log format");
+
+static const char MAGIC[8] = {'D', 'R', 'N', 'F', 'D', 'R', '0', '1'};
+static const uint32_t FORMAT_VERSION = 1;
+
+// First bytes of the file, records follow
+struct FlightLogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t capacity;
+    uint32_t session;           // Session written last
+    uint32_t reserved[9];
+};
+
+static_assert(sizeof(FlightLogHeader) == 64, "Header layout is part of the log format");
+
+// Starts writing the given slots back to the file, does not wait for the device
+static void start_write_back(int fd, size_t first_slot, size_t slots) {
+    off_t offset = static_cast<off_t>(sizeof(FlightLogHeader) + first_slot * sizeof(FlightRecord));
+    sync_file_range(fd, offset, static_cast<off_t>(slots * sizeof(FlightRecord)), SYNC_FILE_RANGE_WRITE);
+}
+
+static bool header_matches(const FlightLogHeader &header, size_t capacity) {
+    return memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.version == FORMAT_VERSION &&
+           header.record_size == sizeof(FlightRecord) && (capacity == 0 || header.capacity == capacity);
+}
+
+FlightRecorder::FlightRecorder()
+    : fd(-1), mapping(nullptr), mapping_size(0), header(nullptr), records(nullptr), capacity(0), session(0), sequence(0),
+      flushed_sequence(0) {}
+
+FlightRecorder::~FlightRecorder() {
+    close();
+}
+
+bool FlightRecorder::open(const std::string &path, size_t record_capacity, std::string &error) {
+    close();
+    if (record_capacity == 0) {
+        error = "capacity must not be 0";
+        return false;
+    }
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd == -1) {
+        error = "cannot open " + path + ": " + strerror(errno);
+        return false;
+    }
+
+    size_t size = sizeof(FlightLogHeader) + record_capacity * sizeof(FlightRecord);
+    // A log of another capacity is dropped, the file is zero filled to the new size
+    struct stat file_stat;
+    bool same_size = fstat(fd, &file_stat) == 0 && static_cast<size_t>(file_stat.st_size) == size;
+    if (!same_size && (ftruncate(fd, 0) != 0 || ftruncate(fd, size) != 0)) {
+        error = "cannot size " + path + ": " + strerror(errno);
+        close();
+        return false;
+    }
+
+    // Populated up front, the control tick never waits for a page fault
+    mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        error = "cannot map " + path + ": " + strerror(errno);
+        close();
+        return false;
+    }
+    mapping_size = size;
+    header = static_cast<FlightLogHeader *>(mapping);
+    records = reinterpret_cast<FlightRecord *>(static_cast<char *>(mapping) + sizeof(FlightLogHeader));
+    capacity = record_capacity;
+
+    if (header_matches(*header, capacity)) {
+        // Continue after the newest record of the previous sessions
+        session = header->session + 1;
+        sequence = 0;
+        for (size_t i = 0; i < capacity; ++i) sequence = std::max(sequence, records[i].sequence);
+    } else {
+        if (same_size) memset(mapping, 0, size);       // A resized file is zero filled already
+        memcpy(header->magic, MAGIC, sizeof(MAGIC));
+        header->version = FORMAT_VERSION;
+        header->record_size = sizeof(FlightRecord);
+        header->capacity = capacity;
+        session = 1;
+        sequence = 0;
+    }
+    header->session = session;
+    flushed_sequence = sequence;
+    sync_file_range(fd, 0, sizeof(FlightLogHeader), SYNC_FILE_RANGE_WRITE);
+    return true;
+}
+
+void FlightRecorder::close() {
+    if (mapping != nullptr) {
+        msync(mapping, mapping_size, MS_SYNC);
+        munmap(mapping, mapping_size);
+    }
+    if (fd != -1) ::close(fd);
+    fd = -1;
+    mapping = nullptr;
+    mapping_size = 0;
+    header = nullptr;
+    records = nullptr;
+    capacity = 0;
+}
+
+bool FlightRecorder::is_open() const {
+    return records != nullptr;
+}
+
+void FlightRecorder::append(const FlightRecord &record) {
+    if (records == nullptr) return;
+
+    uint64_t next = sequence + 1;
+    FlightRecord *slot = &records[(next - 1) % capacity];
+
+    // Invalidate the slot, write the payload, then publish it with its sequence
+    __atomic_store_n(&slot->sequence, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    const size_t payload = offsetof(FlightRecord, tick_ns);
+    memcpy(reinterpret_cast<char *>(slot) + payload, reinterpret_cast<const char *>(&record) + payload, sizeof(FlightRecord) - payload);
+    slot->session = session;
+    __atomic_store_n(&slot->sequence, next, __ATOMIC_RELEASE);
+    sequence = next;
+}
+
+void FlightRecorder::flush() {
+    if (records == nullptr || flushed_sequence == sequence) return;
+
+    // Only the slots written since the last flush; after a wrap around the range is split in two
+    uint64_t count = std::min<uint64_t>(sequence - flushed_sequence, capacity);
+    size_t first = static_cast<size_t>((sequence - count) % capacity);
+    size_t first_part = std::min<size_t>(static_cast<size_t>(count), capacity - first);
+    start_write_back(fd, first, first_part);
+    if (count > first_part) start_write_back(fd, 0, static_cast<size_t>(count) - first_part);
+    flushed_sequence = sequence;
+}
+
+uint32_t FlightRecorder::get_session() const {
+    return session;
+}
+
+uint64_t FlightRecorder::get_sequence() const {
+    return sequence;
+}
+
+bool FlightRecorder::read_file(const std::string &path, std::vector<FlightRecord> &result, std::string &error) {
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file == -1) {
+        error = "cannot open " + path + ": " + strerror(errno);
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(file, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(FlightLogHeader)) {
+        ::close(file);
+        error = path + ": not a flight log";
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(file_stat.st_size);
+    void *data = mmap(nullptr, size, PROT_READ, MAP_SHARED, file, 0);
+    ::close(file);
+    if (data == MAP_FAILED) {
+        error = "cannot map " + path + ": " + strerror(errno);
+        return false;
+    }
+
+    const FlightLogHeader &file_header = *static_cast<const FlightLogHeader *>(data);
+    if (!header_matches(file_header, 0) || sizeof(FlightLogHeader) + file_header.capacity * sizeof(FlightRecord) != size) {
+        munmap(data, size);
+        error = path + ": not a flight log of this version";
+        return false;
+    }
+
+    const FlightRecord *file_records = reinterpret_cast<const FlightRecord *>(static_cast<const char *>(data) + sizeof(FlightLogHeader));
+    result.clear();
+    for (size_t i = 0; i < file_header.capacity; ++i) {
+        if (file_records[i].sequence != 0) result.push_back(file_records[i]);
+    }
+    munmap(data, size);
+
+    std::sort(result.begin(), result.end(), [](const FlightRecord &a, const FlightRecord &b) {
+        return a.sequence < b.sequence;
+    });
+    return true;
+}
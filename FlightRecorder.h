@@ -0,0 +1,101 @@
+#ifndef DRONE_FLIGHT_RECORDER_H
+#define DRONE_FLIGHT_RECORDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One control tick as recorded by the FlightRecorder. Fixed-width fields in a fixed layout, so logs
+// written on the Pi decode on any little-endian machine.
+struct FlightRecord {
+    uint64_t sequence;          // 1 for the first record of a log, 0 for a slot being written
+    int64_t tick_ns;            // Control tick time (monotonic_ns())
+    uint32_t session;           // Incremented every time the log is opened
+    uint32_t duration_ns;       // Time the control tick took
+    uint32_t target_id;         // Active target, 0 if none
+    uint8_t state;              // ControlLoop::PositionControlState
+    uint8_t flags;              // FLAG_* below
+    uint16_t mission_leg;
+
+    // Sensor snapshot used by the tick and the estimated state
+    double gps_latitude;
+    double gps_longitude;
+    double estimate_latitude;
+    double estimate_longitude;
+    float gps_altitude;
+    float gps_speed;            // Knots
+    float gps_course;           // Degrees
+    int32_t gps_age_us;         // -1 without a sample
+    uint8_t gps_fix_quality;
+    uint8_t gps_satellites;
+    uint16_t reserved;
+    float compass_heading;
+    int32_t compass_age_us;     // -1 without a sample
+    float estimate_altitude;
+    float estimate_heading;
+    float estimate_velocity_east;
+    float estimate_velocity_north;
+    float estimate_climb_rate;
+    float estimate_yaw_rate;
+
+    // Temporary target in the mission frame, errors per ControlLoop::ControlAxis and the outputs
+    float target_east;
+    float target_north;
+    float target_up;
+    float target_heading;
+    float errors[4];            // Lateral/forward/altitude in meters, heading in degrees
+    uint16_t channels[4];       // Roll, pitch, throttle, yaw
+    uint32_t padding;
+
+    static constexpr uint8_t FLAG_GPS_STALE = 0x01;
+    static constexpr uint8_t FLAG_COMPASS_STALE = 0x02;
+    static constexpr uint8_t FLAG_STEERING = 0x04;      // Target and errors were computed this tick
+    static constexpr uint8_t FLAG_HOLDING = 0x08;       // Holding a mission waypoint
+};
+
+struct FlightLogHeader;
+
+// Flight data recorder: every control tick goes into a fixed-size ring of FlightRecords in a
+// memory-mapped file. append() copies the record into the mapping without locks or system calls
+// (single producer, the control tick); the kernel writes the pages back on its own, so the log
+// survives a crash of the process. A slot's sequence is cleared before and set after its payload is
+// written, a record torn by a crash reads as empty. flush() starts the write-back of the records
+// appended since the previous flush without waiting for it. It does not make them durable: a power
+// loss can still take records that are in flight or in the drive's cache.
+// Opening an existing log of the same layout continues it with a new session.
+class FlightRecorder {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 18;     // One hour at the control rate, 40 MB
+
+    FlightRecorder();
+    ~FlightRecorder();
+
+    bool open(const std::string &path, size_t capacity, std::string &error);
+    void close();
+    bool is_open() const;
+
+    // Store one record, the sequence and session fields are filled in
+    void append(const FlightRecord &record);
+
+    void flush();
+
+    uint32_t get_session() const;
+    uint64_t get_sequence() const;      // Of the record appended last
+
+    // Records of a log in the order they were written, at most its capacity
+    static bool read_file(const std::string &path, std::vector<FlightRecord> &records, std::string &error);
+
+private:
+    int fd;
+    void *mapping;
+    size_t mapping_size;
+    FlightLogHeader *header;
+    FlightRecord *records;
+    size_t capacity;
+    uint32_t session;
+    uint64_t sequence;
+    uint64_t flushed_sequence;      // Newest record handed to the write-back
+};
+
+#endif // DRONE_FLIGHT_RECORDER_H
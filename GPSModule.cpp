@@ -1,7 +1,9 @@
 #include "GPSModule.h"
+#include "NmeaParser.h"
 #include <fcntl.h>
 #include <unistd.h>
 #include <termios.h>
+#include <poll.h>
 #include <iostream>
 #include <cstring>
 #include <cmath>
@@ -10,14 +12,12 @@
 // Constants
 #define SERIAL_PORT "/dev/ttyAMA0"  // "/dev/serial0"
 #define BAUD_RATE B115200
-#define LINE_BUFFER_SIZE 256
+#define POLL_TIMEOUT_MS 100  // Upper bound for the reader thread to notice a shutdown
 
-GPS::GPS() : gps_fd(-1), latitude(0.0), longitude(0.0), altitude_agl(0.0), speed(0.0), course(0.0), running(true) {}
+GPS::GPS() : gps_fd(-1), fix(), running(true) {}
 
 GPS::~GPS() {
     running = false;
-    fix_quality = -1;
-    satellites = -1;
     if (gps_thread.joinable()) gps_thread.join();
     if (gps_fd != -1) close(gps_fd);
 }
@@ -40,6 +40,8 @@ int GPS::configure_serial_port() {
     options.c_iflag &= ~(IXON | IXOFF | IXANY);
     options.c_iflag &= ~(INLCR | ICRNL | IGNCR);
     options.c_oflag &= ~OPOST;
+    options.c_cc[VMIN] = 0;     // poll() waits for data, read() returns whatever is buffered
+    options.c_cc[VTIME] = 0;
     if (tcsetattr(gps_fd, TCSANOW, &options) != 0) {
         perror("Error setting serial port attributes");
         return -1;
@@ -47,164 +49,128 @@ int GPS::configure_serial_port() {
     return 0;
 }
 
-bool GPS::validate_checksum(const std::string &sentence) {
-    if (sentence[0] != '$') return false;
-    auto checksum_pos = sentence.find('*');
-    if (checksum_pos == std::string::npos || checksum_pos < 1) return false;
+bool GPS::validate_checksum(const NmeaSentence &sentence) {
+    if (sentence.length < 1 || sentence.data[0] != '$') return false;
+    const char *checksum_pos = static_cast<const char *>(memchr(sentence.data, '*', sentence.length));
+    if (checksum_pos == nullptr) return false;
+
+    size_t checksum_index = checksum_pos - sentence.data;
+    if (checksum_index + 3 > sentence.length) return false;
 
     unsigned char checksum = 0;
-    for (size_t i = 1; i < checksum_pos; ++i) {
-        checksum ^= sentence[i];
+    for (size_t i = 1; i < checksum_index; ++i) {
+        checksum ^= sentence.data[i];
     }
 
-    unsigned int received_checksum;
-    sscanf(sentence.c_str() + checksum_pos + 1, "%2x", &received_checksum);
+    unsigned int received_checksum = 0;
+    for (size_t i = checksum_index + 1; i < checksum_index + 3; ++i) {
+        char c = sentence.data[i];
+        received_checksum <<= 4;
+        if (c >= '0' && c <= '9') received_checksum |= c - '0';
+        else if (c >= 'A' && c <= 'F') received_checksum |= c - 'A' + 10;
+        else if (c >= 'a' && c <= 'f') received_checksum |= c - 'a' + 10;
+        else return false;
+    }
     return checksum == received_checksum;
 }
 
 void GPS::gps_reader() {
-    char line_buffer[LINE_BUFFER_SIZE];
-    int line_pos = 0;
-    char c;
+    struct pollfd pfd;
+    pfd.fd = gps_fd;
+    pfd.events = POLLIN;
 
     while (running) {
-        if (read(gps_fd, &c, 1) > 0) {
-            if (c == '\n') {
-                line_buffer[line_pos] = '\0'; // Null-terminate the line
-                std::string sentence(line_buffer);
-                if (validate_checksum(sentence)) {
-                    std::lock_guard<std::mutex> lock(gps_mutex);
-                    if (sentence.find("$GNRMC") != std::string::npos || sentence.find("$GNGGA") != std::string::npos) {
-                        gps_queue.push(sentence);
-                        if (gps_queue.size() > 10) gps_queue.pop(); // Limit queue size
-                    }
-                }
-                else {
-                    std::cout << "Failed to validate checksum for: " << sentence << std::endl;
+        // Sleep until the receiver delivers data, then take everything buffered in one read
+        int ready = poll(&pfd, 1, POLL_TIMEOUT_MS);
+        if (ready <= 0) continue;
+        int64_t received_ns = monotonic_ns();
+
+        size_t capacity;
+        char *dst = gps_splitter.write_ptr(capacity);
+        ssize_t bytes_read = read(gps_fd, dst, capacity);
+        if (bytes_read <= 0) continue;
+        gps_splitter.commit(bytes_read);
+
+        NmeaLine line;
+        while (gps_splitter.next_line(line)) {
+            if (line.length() == 0) continue;
+
+            std::lock_guard<std::mutex> lock(gps_mutex);
+            NmeaSentence sentence = gps_queue.stage(line, received_ns);
+            if (validate_checksum(sentence)) {
+                if (strncmp(sentence.data, "$GNRMC", 6) == 0 || strncmp(sentence.data, "$GNGGA", 6) == 0) {
+                    gps_queue.push();
                 }
-                line_pos = 0; // Reset for the next line
-            } else if (line_pos < LINE_BUFFER_SIZE - 1) {
-                line_buffer[line_pos++] = c;
+            }
+            else {
+                std::cout << "Failed to validate checksum for: " << sentence.data << std::endl;
             }
         }
     }
 }
 
-void GPS::process_gps_data(const std::string &sentence) {
-    try {
-        if (sentence.find("$GNRMC") != std::string::npos) {
-            char time_buf[11], lat_buf[11], lon_buf[12], speed_buf[8], cog_buf[8], date_buf[7];
-            char ns = 0, ew = 0, status = 0;
-
-            // Parse $GNRMC
-            int parsed = sscanf(sentence.c_str(),
-                "$GNRMC,%10[^,],%c,%10[^,],%c,%11[^,],%c,%7[^,],%7[^,],%6[^,]",
-                time_buf, &status, lat_buf, &ns, lon_buf, &ew, speed_buf, cog_buf, date_buf);
-
-            if (status != 'A' || strlen(time_buf) == 0) { // Ensure valid time and status
-                std::cerr << "Skipping invalid or incomplete $GNRMC sentence." << std::endl;
-                return;
-            }
-
-            // Convert latitude and longitude
-            float parsed_lat = convert_to_decimal_degrees(lat_buf, ns);
-            float parsed_lon = convert_to_decimal_degrees(lon_buf, ew);
-
-            // Validate latitude and longitude ranges
-            if (parsed_lat < -90.0 || parsed_lat > 90.0 || parsed_lon < -180.0 || parsed_lon > 180.0) {
-                std::cerr << "Skipping out-of-range latitude or longitude in $GNRMC." << std::endl;
-                return;
-            }
-
-            // Update GPS values
-            time = time_buf;
-            latitude = parsed_lat;
-            longitude = parsed_lon;
-            speed = atof(speed_buf);    // Speed over ground (knots)
-            course = atof(cog_buf);    // Course over ground (degrees)
-
-            // std::cout << "Updated GNRMC data - Time: " << time << ", Lat: " << latitude << ", Lon: " << longitude
-            //           << ", Speed: " << speed << ", Course: " << course << std::endl;
-
-        } else if (sentence.find("$GNGGA") != std::string::npos) {
-            char time_buf[11], lat_buf[11], lon_buf[12], alt_buf[8], geoid_buf[8];
-            char ns = 0, ew = 0;
-            int fix_quality_local = 0, satellites_local = 0;
-            float hdop_local = 0.0;
-
-            // Parse $GNGGA
-            int parsed = sscanf(sentence.c_str(),
-                "$GNGGA,%10[^,],%10[^,],%c,%11[^,],%c,%d,%d,%f,%7[^,],M,%7[^,],M",
-                time_buf, lat_buf, &ns, lon_buf, &ew, &fix_quality_local, &satellites_local, &hdop_local, alt_buf, geoid_buf);
-
-            if (parsed < 10 || strlen(time_buf) == 0) { // Ensure valid time
-                std::cerr << "Skipping invalid or incomplete $GNGGA sentence." << std::endl;
-                return;
-            }
-
-            // Convert latitude and longitude
-            float parsed_lat = convert_to_decimal_degrees(lat_buf, ns);
-            float parsed_lon = convert_to_decimal_degrees(lon_buf, ew);
-
-            // Validate latitude and longitude ranges
-            if (parsed_lat < -90.0 || parsed_lat > 90.0 || parsed_lon < -180.0 || parsed_lon > 180.0) {
-                std::cerr << "Skipping out-of-range latitude or longitude in $GNGGA." << std::endl;
-                return;
-            }
-
-            // Convert altitude and validate
-            float parsed_altitude = atof(alt_buf);
-            float parsed_geoid = atof(geoid_buf);
-            if (parsed_altitude < -1000.0 || parsed_altitude > 10000.0) { // Sanity check altitude
-                std::cerr << "Skipping invalid altitude in $GNGGA." << std::endl;
-                return;
-            }
-
-            // Update GPS values
-            time = time_buf;
-            latitude = parsed_lat;
-            longitude = parsed_lon;
-            altitude_agl = parsed_altitude - parsed_geoid; // Altitude above ground level
-            fix_quality = fix_quality_local;
-            satellites = satellites_local;
-
-            // std::cout << "Updated GNGGA data - Time: " << time << ", Lat: " << latitude << ", Lon: " << longitude
-            //           << ", Altitude: " << altitude_agl << ", Satellites: " << satellites << std::endl;
-
+bool GPS::process_gps_data(const NmeaSentence &sentence) {
+    if (strncmp(sentence.data, "$GNRMC", 6) == 0) {
+        NmeaRmc rmc;
+        if (!NmeaParser::parse_rmc(sentence, rmc) || !rmc.active) { // Ensure valid time and status
+            std::cerr << "Skipping invalid or incomplete $GNRMC sentence." << std::endl;
+            return false;
         }
 
-    } catch (const std::exception &e) {
-        std::cerr << "Error while processing GPS data: " << e.what() << std::endl;
-    }
-}
+        // Validate latitude and longitude ranges
+        if (rmc.latitude < -90.0 || rmc.latitude > 90.0 || rmc.longitude < -180.0 || rmc.longitude > 180.0) {
+            std::cerr << "Skipping out-of-range latitude or longitude in $GNRMC." << std::endl;
+            return false;
+        }
 
-float GPS::convert_to_decimal_degrees(const char *coord, char direction) {
-    if (coord == nullptr || strlen(coord) < 4 || !(direction == 'N' || direction == 'S' || direction == 'E' || direction == 'W')) {
-        throw std::invalid_argument("Invalid coordinate or direction");
-    }
+        // Update GPS values
+        memcpy(fix.time, rmc.time, sizeof(fix.time));
+        fix.latitude = rmc.latitude;
+        fix.longitude = rmc.longitude;
+        fix.speed = rmc.speed;      // Speed over ground (knots)
+        fix.course = rmc.course;    // Course over ground (degrees)
+
+        // std::cout << "Updated GNRMC data - Time: " << fix.time << ", Lat: " << fix.latitude << ", Lon: " << fix.longitude
+        //           << ", Speed: " << fix.speed << ", Course: " << fix.course << std::endl;
+        return true;
+
+    } else if (strncmp(sentence.data, "$GNGGA", 6) == 0) {
+        NmeaGga gga;
+        if (!NmeaParser::parse_gga(sentence, gga)) { // Ensure valid time
+            std::cerr << "Skipping invalid or incomplete $GNGGA sentence." << std::endl;
+            return false;
+        }
 
-    float degrees = 0.0, minutes = 0.0;
+        // Without a position the receiver still reports fix quality and satellites, keep reliability up to date
+        fix.fix_quality = gga.fix_quality;
+        fix.satellites = gga.satellites;
+        if (!gga.has_position) {
+            return true;
+        }
 
-    // Determine the format based on input length (latitude vs longitude)
-    if (direction == 'E' || direction == 'W') { // Longitude (DDDMM.MMMM)
-        if (sscanf(coord, "%3f%f", &degrees, &minutes) != 2) {
-            throw std::invalid_argument("Failed to parse longitude coordinate");
+        // Validate latitude and longitude ranges
+        if (gga.latitude < -90.0 || gga.latitude > 90.0 || gga.longitude < -180.0 || gga.longitude > 180.0) {
+            std::cerr << "Skipping out-of-range latitude or longitude in $GNGGA." << std::endl;
+            return true;
         }
-    } else { // Latitude (DDMM.MMMM)
-        if (sscanf(coord, "%2f%f", &degrees, &minutes) != 2) {
-            throw std::invalid_argument("Failed to parse latitude coordinate");
+
+        // Validate altitude
+        if (gga.altitude < -1000.0 || gga.altitude > 10000.0) { // Sanity check altitude
+            std::cerr << "Skipping invalid altitude in $GNGGA." << std::endl;
+            return true;
         }
-    }
 
-    // Convert to decimal degrees
-    float decimal = degrees + (minutes / 60.0);
+        // Update GPS values
+        memcpy(fix.time, gga.time, sizeof(fix.time));
+        fix.latitude = gga.latitude;
+        fix.longitude = gga.longitude;
+        fix.altitude_agl = gga.altitude - gga.geoid; // Altitude above ground level
 
-    // Apply hemisphere correction
-    if (direction == 'S' || direction == 'W') {
-        decimal = -decimal;
+        // std::cout << "Updated GNGGA data - Time: " << fix.time << ", Lat: " << fix.latitude << ", Lon: " << fix.longitude
+        //           << ", Altitude: " << fix.altitude_agl << ", Satellites: " << fix.satellites << std::endl;
+        return true;
     }
-
-    return decimal;
+    return false;
 }
 
 bool GPS::init() {
@@ -225,24 +191,43 @@ bool GPS::init() {
 
 void GPS::update() {
     std::lock_guard<std::mutex> lock(gps_mutex);
-    while (!gps_queue.empty()) {
-        process_gps_data(gps_queue.front());
-        gps_queue.pop();
+    bool changed = false;
+    int64_t capture_ns = 0;
+    NmeaSentence sentence;
+    while (gps_queue.pop(sentence)) {
+        if (process_gps_data(sentence)) {
+            changed = true;
+            capture_ns = sentence.timestamp_ns;
+        }
+    }
+    if (changed) {
+        // Stamped with the arrival of the newest sentence, not with the time update() ran
+        latest_fix.publish(fix, capture_ns);
     }
 }
 
 bool GPS::is_data_reliable() const {
-    if (fix_quality > 0 && satellites >= 4) {
-        return true; // Good GPS data
+    return latest_fix.value().is_reliable();
+}
+
+GpsFix GPS::get_fix() const {
+    return latest_fix.value();
+}
+
+Sample<GpsFix> GPS::get_fix_sample() const {
+    Sample<GpsFix> sample;
+    if (!latest_fix.read(sample)) {
+        sample.value = GpsFix();
     }
-    return false; // Insufficient fix quality or satellites
+    return sample;
 }
 
-float GPS::get_latitude() const { return latitude; }
-float GPS::get_longitude() const { return longitude; }
-float GPS::get_altitude_agl() const { return altitude_agl; }
-float GPS::get_speed() const { return speed; }
-float GPS::get_course() const { return course; }
-int GPS::get_fix_quality() const { return fix_quality; }
-int GPS::get_satellites() const { return satellites; }
-std::string GPS::get_time() const { return time; }
+GeoPosition GPS::get_position() const { return latest_fix.value().position(); }
+double GPS::get_latitude() const { return latest_fix.value().latitude; }
+double GPS::get_longitude() const { return latest_fix.value().longitude; }
+float GPS::get_altitude_agl() const { return latest_fix.value().altitude_agl; }
+float GPS::get_speed() const { return latest_fix.value().speed; }
+float GPS::get_course() const { return latest_fix.value().course; }
+int GPS::get_fix_quality() const { return latest_fix.value().fix_quality; }
+int GPS::get_satellites() const { return latest_fix.value().satellites; }
+std::string GPS::get_time() const { return latest_fix.value().time; }
@@ -2,58 +2,57 @@
 #define DRONE_GPS_MODULE_H
 
 #include <string>
-#include <queue>
 #include <mutex>
 #include <thread>
+#include <atomic>
+#include "NmeaBuffer.h"
+#include "SensorInterfaces.h"
 
-class GPS {
+// GPS receiver on the serial port, NMEA sentences are read by a thread and published by update()
+class GPS : public PositionSource {
 private:
     int gps_fd; // File descriptor for the serial port
     std::thread gps_thread;
     std::mutex gps_mutex;
-    std::queue<std::string> gps_queue;
+    NmeaLineSplitter gps_splitter;  // Raw serial ring, used by the reader thread only
+    NmeaSentenceQueue gps_queue;    // Sentences waiting for update(), protected by gps_mutex
 
-    // Latest values
-    std::string time;
-    float latitude;
-    float longitude;
-    float altitude_agl;
-    float speed;
-    float course;
-    int fix_quality;
-    int satellites;
+    GpsFix fix;                         // Working copy updated by update(), protected by gps_mutex
+    LatestSample<GpsFix> latest_fix;    // Published snapshot, read without locking
 
-    bool running;
+    std::atomic<bool> running;
 
     // Configure the serial port
     int configure_serial_port();
 
     // Validate NMEA checksum
-    bool validate_checksum(const std::string &sentence);
+    bool validate_checksum(const NmeaSentence &sentence);
 
     // Reader thread function
     void gps_reader();
 
-    // Process GPS data
-    void process_gps_data(const std::string &sentence);
-
-    // Convert NMEA latitude/longitude to decimal degrees
-    float convert_to_decimal_degrees(const char *coord, char direction);
+    // Process GPS data, returns true if the working copy changed
+    bool process_gps_data(const NmeaSentence &sentence);
 
 public:
     GPS();
     ~GPS();
 
     // Initialize the GPS
-    bool init();
+    bool init() override;
 
-    // Fetch the latest GPS values
-    void update();
+    // Process received sentences and publish the new values
+    void update() override;
     bool is_data_reliable() const;
 
-    // Getters for GPS values
-    float get_latitude() const;
-    float get_longitude() const;
+    // Consistent snapshot of all GPS values (lock-free)
+    GpsFix get_fix() const;
+    Sample<GpsFix> get_fix_sample() const override;
+
+    // Getters for single GPS values, each reads its own snapshot
+    GeoPosition get_position() const;
+    double get_latitude() const;
+    double get_longitude() const;
     float get_altitude_agl() const;
     float get_speed() const;
     float get_course() const;
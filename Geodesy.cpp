@@ -0,0 +1,73 @@
+#include "Geodesy.h"
+#include <cmath>
+
+static constexpr double EARTH_RADIUS = 6371000.0; // Earth's radius in meters
+static constexpr double DEG_TO_RAD = M_PI / 180.0;
+static constexpr double RAD_TO_DEG = 180.0 / M_PI;
+
+double geo_distance(const GeoPosition &from, const GeoPosition &to) {
+    double dlat = (to.latitude - from.latitude) * DEG_TO_RAD;
+    double dlon = (to.longitude - from.longitude) * DEG_TO_RAD;
+
+    double a = std::sin(dlat / 2) * std::sin(dlat / 2) +
+               std::cos(from.latitude * DEG_TO_RAD) * std::cos(to.latitude * DEG_TO_RAD) *
+                   std::sin(dlon / 2) * std::sin(dlon / 2);
+    double c = 2 * std::atan2(std::sqrt(a), std::sqrt(1 - a));
+
+    return EARTH_RADIUS * c; // Distance in meters
+}
+
+double geo_bearing(const GeoPosition &from, const GeoPosition &to) {
+    double dlon = (to.longitude - from.longitude) * DEG_TO_RAD;
+    double lat1 = from.latitude * DEG_TO_RAD;
+    double lat2 = to.latitude * DEG_TO_RAD;
+
+    double y = std::sin(dlon) * std::cos(lat2);
+    double x = std::cos(lat1) * std::sin(lat2) - std::sin(lat1) * std::cos(lat2) * std::cos(dlon);
+
+    double bearing = std::atan2(y, x) * RAD_TO_DEG;
+    return std::fmod(bearing + 360.0, 360.0); // Normalize to [0, 360)
+}
+
+GeoPosition geo_offset(const GeoPosition &origin, double bearing, double distance) {
+    double delta_lat = (distance / EARTH_RADIUS) * RAD_TO_DEG * std::cos(bearing * DEG_TO_RAD);
+    double delta_lon = (distance / EARTH_RADIUS) * RAD_TO_DEG * std::sin(bearing * DEG_TO_RAD) / std::cos(origin.latitude * DEG_TO_RAD);
+    GeoPosition position = {origin.latitude + delta_lat, origin.longitude + delta_lon, origin.altitude};
+    return position;
+}
+
+LocalFrame::LocalFrame() : origin({0.0, 0.0, 0.0f}), meters_per_degree_lat(0.0), meters_per_degree_lon(0.0) {
+    set_origin(origin);
+}
+
+LocalFrame::LocalFrame(const GeoPosition &origin) : LocalFrame() {
+    set_origin(origin);
+}
+
+void LocalFrame::set_origin(const GeoPosition &new_origin) {
+    origin = new_origin;
+    meters_per_degree_lat = EARTH_RADIUS * DEG_TO_RAD;
+    meters_per_degree_lon = EARTH_RADIUS * DEG_TO_RAD * std::cos(origin.latitude * DEG_TO_RAD);
+}
+
+const GeoPosition &LocalFrame::get_origin() const {
+    return origin;
+}
+
+EnuPoint LocalFrame::to_enu(const GeoPosition &position) const {
+    EnuPoint point = {
+        (position.longitude - origin.longitude) * meters_per_degree_lon,
+        (position.latitude - origin.latitude) * meters_per_degree_lat,
+        position.altitude - origin.altitude,
+    };
+    return point;
+}
+
+GeoPosition LocalFrame::to_geodetic(const EnuPoint &point) const {
+    GeoPosition position = {
+        origin.latitude + point.north / meters_per_degree_lat,
+        origin.longitude + point.east / meters_per_degree_lon,
+        origin.altitude + point.up,
+    };
+    return position;
+}
@@ -0,0 +1,49 @@
+#ifndef DRONE_GEODESY_H
+#define DRONE_GEODESY_H
+
+// Geodetic position. Latitude and longitude need double precision: a float has a 24 bit mantissa,
+// which at 50° latitude quantizes positions to roughly a meter.
+struct GeoPosition {
+    double latitude;    // Decimal degrees
+    double longitude;   // Decimal degrees
+    float altitude;     // Meters above ground
+};
+
+// Great circle distance between two positions in meters (Haversine formula), altitude is ignored
+double geo_distance(const GeoPosition &from, const GeoPosition &to);
+
+// Initial bearing from one position to another in degrees [0, 360)
+double geo_bearing(const GeoPosition &from, const GeoPosition &to);
+
+// Position reached when moving <distance> meters from <origin> along <bearing> degrees (flat earth
+// approximation, valid for the short distances the control loop works with). Altitude is kept.
+GeoPosition geo_offset(const GeoPosition &origin, double bearing, double distance);
+
+// Point in a local East-North-Up tangent plane, meters from the frame origin
+struct EnuPoint {
+    double east;
+    double north;
+    float up;
+};
+
+// Local tangent plane anchored at an origin. Projecting is a handful of multiplies and adds,
+// so per-tick errors can be computed without trigonometry. Uses the same spherical earth as
+// geo_distance(), the projection error stays in the centimeter range over a few kilometers.
+class LocalFrame {
+public:
+    LocalFrame();
+    explicit LocalFrame(const GeoPosition &origin);
+
+    void set_origin(const GeoPosition &origin);
+    const GeoPosition &get_origin() const;
+
+    EnuPoint to_enu(const GeoPosition &position) const;
+    GeoPosition to_geodetic(const EnuPoint &point) const;
+
+private:
+    GeoPosition origin;
+    double meters_per_degree_lat;
+    double meters_per_degree_lon;
+};
+
+#endif // DRONE_GEODESY_H
@@ -0,0 +1,59 @@
+#ifndef DRONE_KALMAN_FILTER_H
+#define DRONE_KALMAN_FILTER_H
+
+#include "Matrix.h"
+
+// Linear Kalman filter with N states. The model matrices are passed per step, so the caller can
+// build them for the actual time step; measurement sizes are template parameters of update().
+template <size_t N>
+class KalmanFilter {
+public:
+    typedef Matrix<N, 1> State;
+    typedef Matrix<N, N> Covariance;
+
+    KalmanFilter() : x(State::zero()), P(Covariance::identity()) {}
+
+    void reset(const State &state, const Covariance &covariance) {
+        x = state;
+        P = covariance;
+    }
+
+    // x = F x, P = F P F' + Q
+    void predict(const Matrix<N, N> &F, const Matrix<N, N> &Q) {
+        x = F * x;
+        P = F * P * F.transpose() + Q;
+    }
+
+    // Measurement update with the innovation y = z - H x computed by the caller (lets it wrap angles).
+    // Returns false and leaves the state untouched if the innovation covariance is singular.
+    template <size_t M>
+    bool update(const Matrix<M, 1> &innovation, const Matrix<M, N> &H, const Matrix<M, M> &R) {
+        Matrix<N, M> PHt = P * H.transpose();
+        Matrix<M, M> S = H * PHt + R;
+        Matrix<M, M> S_inverse;
+        if (!invert(S, S_inverse)) return false;
+
+        Matrix<N, M> K = PHt * S_inverse;
+        x += K * innovation;
+
+        // Joseph form keeps P symmetric and positive definite despite rounding
+        Matrix<N, N> I_KH = Covariance::identity() - K * H;
+        P = I_KH * P * I_KH.transpose() + K * R * K.transpose();
+        return true;
+    }
+
+    template <size_t M>
+    bool update_measurement(const Matrix<M, 1> &z, const Matrix<M, N> &H, const Matrix<M, M> &R) {
+        return update(z - H * x, H, R);
+    }
+
+    const State &state() const { return x; }
+    State &state() { return x; }
+    const Covariance &covariance() const { return P; }
+
+private:
+    State x;
+    Covariance P;
+};
+
+#endif // DRONE_KALMAN_FILTER_H
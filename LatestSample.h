@@ -0,0 +1,85 @@
+#ifndef DRONE_LATEST_SAMPLE_H
+#define DRONE_LATEST_SAMPLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "MonotonicClock.h"
+
+// Sample as published by a sensor
+template <typename T>
+struct Sample {
+    T value;
+    int64_t timestamp_ns;   // monotonic_ns() time of the sample
+    uint64_t sequence;      // 1 for the first published sample, 0 if nothing was published yet
+};
+
+// "Latest value" mailbox implemented as a seqlock. One writer publishes, any number of readers
+// take consistent multi-field snapshots. Readers never take a lock and never block the writer,
+// they only retry in the rare case that a publish overlapped their copy.
+// The payload is stored as relaxed atomic words, so concurrent copies are well defined.
+template <typename T>
+class LatestSample {
+    static_assert(std::is_trivially_copyable<T>::value, "LatestSample requires a trivially copyable type");
+
+public:
+    LatestSample() : sequence(0), timestamp_ns(0) {
+        for (size_t i = 0; i < WORDS; ++i) words[i].store(0, std::memory_order_relaxed);
+    }
+
+    // Publish a new value (single writer, or writers serialized by the caller)
+    void publish(const T &value, int64_t sample_time_ns = monotonic_ns()) {
+        uint64_t buffer[WORDS] = {};
+        memcpy(buffer, &value, sizeof(T));
+
+        uint64_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);     // Odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < WORDS; ++i) words[i].store(buffer[i], std::memory_order_relaxed);
+        timestamp_ns.store(sample_time_ns, std::memory_order_relaxed);
+
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Latest sample, returns false if nothing was published yet
+    bool read(Sample<T> &sample) const {
+        uint64_t buffer[WORDS];
+        uint64_t seq_before, seq_after;
+        int64_t time;
+        do {
+            seq_before = sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WORDS; ++i) buffer[i] = words[i].load(std::memory_order_relaxed);
+            time = timestamp_ns.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            seq_after = sequence.load(std::memory_order_relaxed);
+        } while (seq_before != seq_after || (seq_before & 1));
+
+        memcpy(&sample.value, buffer, sizeof(T));
+        sample.timestamp_ns = time;
+        sample.sequence = seq_before / 2;
+        return seq_before != 0;
+    }
+
+    // Latest value only, a default constructed value if nothing was published yet
+    T value() const {
+        Sample<T> sample;
+        if (!read(sample)) return T();
+        return sample.value;
+    }
+
+    // Number of published samples
+    uint64_t get_sequence() const {
+        return sequence.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> words[WORDS];
+    std::atomic<int64_t> timestamp_ns;
+};
+
+#endif // DRONE_LATEST_SAMPLE_H
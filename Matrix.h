@@ -0,0 +1,120 @@
+#ifndef DRONE_MATRIX_H
+#define DRONE_MATRIX_H
+
+#include <cmath>
+#include <cstddef>
+
+// Fixed size, row-major matrix for the state estimator. Dimensions are template parameters,
+// so shape errors fail to compile and all storage lives on the stack (no allocations).
+template <size_t R, size_t C>
+struct Matrix {
+    double m[R][C];
+
+    static constexpr size_t ROWS = R;
+    static constexpr size_t COLS = C;
+
+    static Matrix zero() {
+        Matrix result;
+        for (size_t i = 0; i < R; ++i)
+            for (size_t j = 0; j < C; ++j) result.m[i][j] = 0.0;
+        return result;
+    }
+
+    static Matrix identity() {
+        static_assert(R == C, "identity requires a square matrix");
+        Matrix result = zero();
+        for (size_t i = 0; i < R; ++i) result.m[i][i] = 1.0;
+        return result;
+    }
+
+    double &operator()(size_t row, size_t col) { return m[row][col]; }
+    double operator()(size_t row, size_t col) const { return m[row][col]; }
+
+    // Element access for column vectors
+    double &operator[](size_t row) { return m[row][0]; }
+    double operator[](size_t row) const { return m[row][0]; }
+
+    Matrix<C, R> transpose() const {
+        Matrix<C, R> result;
+        for (size_t i = 0; i < R; ++i)
+            for (size_t j = 0; j < C; ++j) result.m[j][i] = m[i][j];
+        return result;
+    }
+
+    Matrix &operator+=(const Matrix &other) {
+        for (size_t i = 0; i < R; ++i)
+            for (size_t j = 0; j < C; ++j) m[i][j] += other.m[i][j];
+        return *this;
+    }
+
+    Matrix &operator-=(const Matrix &other) {
+        for (size_t i = 0; i < R; ++i)
+            for (size_t j = 0; j < C; ++j) m[i][j] -= other.m[i][j];
+        return *this;
+    }
+};
+
+template <size_t R, size_t C>
+Matrix<R, C> operator+(Matrix<R, C> a, const Matrix<R, C> &b) {
+    return a += b;
+}
+
+template <size_t R, size_t C>
+Matrix<R, C> operator-(Matrix<R, C> a, const Matrix<R, C> &b) {
+    return a -= b;
+}
+
+template <size_t R, size_t K, size_t C>
+Matrix<R, C> operator*(const Matrix<R, K> &a, const Matrix<K, C> &b) {
+    Matrix<R, C> result;
+    for (size_t i = 0; i < R; ++i) {
+        for (size_t j = 0; j < C; ++j) {
+            double sum = 0.0;
+            for (size_t k = 0; k < K; ++k) sum += a.m[i][k] * b.m[k][j];
+            result.m[i][j] = sum;
+        }
+    }
+    return result;
+}
+
+// Inverse by Gauss-Jordan elimination with partial pivoting, returns false if the matrix is singular.
+// Only used for the small innovation covariances (one row per measurement).
+template <size_t N>
+bool invert(const Matrix<N, N> &matrix, Matrix<N, N> &inverse) {
+    Matrix<N, N> a = matrix;
+    inverse = Matrix<N, N>::identity();
+
+    for (size_t col = 0; col < N; ++col) {
+        size_t pivot = col;
+        for (size_t row = col + 1; row < N; ++row) {
+            if (std::fabs(a.m[row][col]) > std::fabs(a.m[pivot][col])) pivot = row;
+        }
+        if (std::fabs(a.m[pivot][col]) < 1e-12) return false;
+
+        if (pivot != col) {
+            for (size_t j = 0; j < N; ++j) {
+                double t = a.m[col][j]; a.m[col][j] = a.m[pivot][j]; a.m[pivot][j] = t;
+                t = inverse.m[col][j]; inverse.m[col][j] = inverse.m[pivot][j]; inverse.m[pivot][j] = t;
+            }
+        }
+
+        double scale = 1.0 / a.m[col][col];
+        for (size_t j = 0; j < N; ++j) {
+            a.m[col][j] *= scale;
+            inverse.m[col][j] *= scale;
+        }
+
+        for (size_t row = 0; row < N; ++row) {
+            if (row == col) continue;
+            double factor = a.m[row][col];
+            if (factor == 0.0) continue;
+            for (size_t j = 0; j < N; ++j) {
+                a.m[row][j] -= factor * a.m[col][j];
+                inverse.m[row][j] -= factor * inverse.m[col][j];
+            }
+        }
+    }
+    return true;
+}
+
+#endif // DRONE_MATRIX_H
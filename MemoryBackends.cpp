@@ -0,0 +1,95 @@
+#include "MemoryBackends.h"
+
+bool MemoryPositionSource::init() {
+    return true;
+}
+
+Sample<GpsFix> MemoryPositionSource::get_fix_sample() const {
+    Sample<GpsFix> sample;
+    if (!latest_fix.read(sample)) {
+        sample.value = GpsFix();
+    }
+    return sample;
+}
+
+void MemoryPositionSource::publish(const GpsFix &fix, int64_t timestamp_ns) {
+    latest_fix.publish(fix, timestamp_ns);
+}
+
+bool MemoryHeadingSource::init() {
+    return true;
+}
+
+Sample<CompassSample> MemoryHeadingSource::get_sample() const {
+    Sample<CompassSample> sample;
+    if (!latest_sample.read(sample)) {
+        sample.value = CompassSample();
+    }
+    return sample;
+}
+
+void MemoryHeadingSource::publish(const CompassSample &sample, int64_t timestamp_ns) {
+    latest_sample.publish(sample, timestamp_ns);
+}
+
+MemoryRcInput::MemoryRcInput() : last_packet_ns(0), packet_count(0), stopped(false) {}
+
+bool MemoryRcInput::init() {
+    return true;
+}
+
+void MemoryRcInput::set_packet_listener(PacketListener packet_listener) {
+    listener = packet_listener;
+}
+
+bool MemoryRcInput::run() {
+    std::unique_lock<std::mutex> lock(run_mutex);
+    stopped_condition.wait(lock, [this] { return stopped; });
+    stopped = false;
+    return true;
+}
+
+void MemoryRcInput::stop() {
+    std::lock_guard<std::mutex> lock(run_mutex);
+    stopped = true;
+    stopped_condition.notify_all();
+}
+
+int64_t MemoryRcInput::get_last_packet_ns() const {
+    return last_packet_ns;
+}
+
+uint64_t MemoryRcInput::get_packet_count() const {
+    return packet_count;
+}
+
+uint64_t MemoryRcInput::get_error_count() const {
+    return 0;
+}
+
+void MemoryRcInput::deliver(const sbus_packet_t &packet, int64_t arrival_ns) {
+    last_packet_ns = arrival_ns;
+    packet_count++;
+    if (listener) listener(packet);
+}
+
+bool MemoryRcOutput::init() {
+    return true;
+}
+
+bool MemoryRcOutput::write(const sbus_packet_t &packet) {
+    last_packet.publish(packet);
+    return true;
+}
+
+Sample<sbus_packet_t> MemoryRcOutput::get_last_packet() const {
+    Sample<sbus_packet_t> sample;
+    if (!last_packet.read(sample)) {
+        sample.value = sbus_packet_t();
+    }
+    return sample;
+}
+
+uint64_t MemoryRcOutput::get_write_count() const {
+    return last_packet.get_sequence();
+}
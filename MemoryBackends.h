@@ -0,0 +1,75 @@
+#ifndef DRONE_MEMORY_BACKENDS_H
+#define DRONE_MEMORY_BACKENDS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include "RcInterfaces.h"
+#include "SensorInterfaces.h"
+
+// Hardware interfaces backed by memory: the caller publishes the data a device would deliver and
+// reads what would have been sent. Used by benchmarks, load tests and the sensor replay.
+
+class MemoryPositionSource : public PositionSource {
+public:
+    bool init() override;
+    Sample<GpsFix> get_fix_sample() const override;
+
+    // Publish a fix as received at <timestamp_ns> (monotonic_ns()), single writer
+    void publish(const GpsFix &fix, int64_t timestamp_ns = monotonic_ns());
+
+private:
+    LatestSample<GpsFix> latest_fix;
+};
+
+class MemoryHeadingSource : public HeadingSource {
+public:
+    bool init() override;
+    Sample<CompassSample> get_sample() const override;
+
+    void publish(const CompassSample &sample, int64_t timestamp_ns = monotonic_ns());
+
+private:
+    LatestSample<CompassSample> latest_sample;
+};
+
+// Packets are delivered by deliver() on the calling thread; run() only waits for stop(), so code
+// that runs the receiver in a thread of its own works unchanged.
+class MemoryRcInput : public RcInput {
+public:
+    MemoryRcInput();
+
+    bool init() override;
+    void set_packet_listener(PacketListener listener) override;
+    bool run() override;
+    void stop() override;
+    int64_t get_last_packet_ns() const override;
+    uint64_t get_packet_count() const override;
+    uint64_t get_error_count() const override;
+
+    // Hand a packet to the listener as received at <arrival_ns>
+    void deliver(const sbus_packet_t &packet, int64_t arrival_ns = monotonic_ns());
+
+private:
+    PacketListener listener;
+    std::atomic<int64_t> last_packet_ns;
+    std::atomic<uint64_t> packet_count;
+    std::mutex run_mutex;
+    std::condition_variable stopped_condition;
+    bool stopped;
+};
+
+// Keeps the packet written last, readers poll it without locking
+class MemoryRcOutput : public RcOutput {
+public:
+    bool init() override;
+    bool write(const sbus_packet_t &packet) override;
+
+    Sample<sbus_packet_t> get_last_packet() const;
+    uint64_t get_write_count() const;
+
+private:
+    LatestSample<sbus_packet_t> last_packet;
+};
+
+#endif // DRONE_MEMORY_BACKENDS_H
@@ -0,0 +1,48 @@
+#include "MessageEncoding.h"
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+bool parseEncoding(const std::string& name, MessageEncoding& encoding) {
+    if (name == "JSON") {
+        encoding = MessageEncoding::JSON;
+    } else if (name == "CBOR") {
+        encoding = MessageEncoding::CBOR;
+    } else if (name == "MSGPACK") {
+        encoding = MessageEncoding::MSGPACK;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* encodingName(MessageEncoding encoding) {
+    switch (encoding) {
+        case MessageEncoding::CBOR: return "CBOR";
+        case MessageEncoding::MSGPACK: return "MSGPACK";
+        default: return "JSON";
+    }
+}
+
+std::string encodeMessage(MessageEncoding encoding, const json& message) {
+    std::string encoded;
+    switch (encoding) {
+        case MessageEncoding::CBOR:
+            json::to_cbor(message, encoded);
+            break;
+        case MessageEncoding::MSGPACK:
+            json::to_msgpack(message, encoded);
+            break;
+        default:
+            // Strings from clients may be invalid UTF-8, they are sent with replacement characters
+            encoded = message.dump(-1, ' ', false, json::error_handler_t::replace);
+            break;
+    }
+    return encoded;
+}
+
+json decodeMessage(MessageEncoding encoding, const std::string& message) {
+    if (encoding == MessageEncoding::JSON || (!message.empty() && message[0] == '{')) return json::parse(message);
+    if (encoding == MessageEncoding::CBOR) return json::from_cbor(message);
+    return json::from_msgpack(message);
+}
@@ -0,0 +1,21 @@
+#ifndef DRONE_MESSAGE_ENCODING_H
+#define DRONE_MESSAGE_ENCODING_H
+
+#include <string>
+#include <nlohmann/json_fwd.hpp>
+
+// Encoding of the messages inside Connector frames, chosen per connection with the ENCODING command.
+// The binary encodings need length-prefixed framing, they may contain any byte.
+enum class MessageEncoding { JSON, CBOR, MSGPACK };
+
+// "JSON", "CBOR" or "MSGPACK", returns false for unknown names
+bool parseEncoding(const std::string& name, MessageEncoding& encoding);
+const char* encodingName(MessageEncoding encoding);
+
+std::string encodeMessage(MessageEncoding encoding, const nlohmann::json& message);
+
+// Decode a received message, throws nlohmann::json::exception if it is malformed.
+// JSON text ('{') is accepted in every encoding, so a client can always fall back to it.
+nlohmann::json decodeMessage(MessageEncoding encoding, const std::string& message);
+
+#endif // DRONE_MESSAGE_ENCODING_H
@@ -0,0 +1,131 @@
+#include "MessageFraming.h"
+
+constexpr size_t FrameDecoder::MAX_FRAME_SIZE;
+
+// Consumed bytes are dropped from the front of the buffer once they exceed this
+static const size_t COMPACT_THRESHOLD = 4096;
+
+FrameDecoder::FrameDecoder()
+    : mode(FramingMode::DETECT), start(0), scan(0), depth(0), inString(false), escape(false), failed(false) {}
+
+void FrameDecoder::append(const char* data, size_t length) {
+    if (failed) return;
+    buffer.append(data, length);
+}
+
+FrameDecoder::Result FrameDecoder::next(std::string& frame) {
+    if (failed) return Result::ERROR;
+    if (start == buffer.size()) return Result::INCOMPLETE;
+
+    if (mode == FramingMode::DETECT) {
+        mode = buffer[start] == '\0' ? FramingMode::LENGTH_PREFIXED : FramingMode::JSON_TEXT;
+    }
+
+    Result result = mode == FramingMode::LENGTH_PREFIXED ? nextLengthPrefixed(frame) : nextJson(frame);
+    if (result == Result::ERROR) {
+        failed = true;
+        buffer.clear();
+        start = scan = 0;
+    }
+    return result;
+}
+
+FrameDecoder::Result FrameDecoder::nextJson(std::string& frame) {
+    while (scan < buffer.size()) {
+        char c = buffer[scan];
+
+        if (depth == 0) {
+            if (c == '\n') {
+                // Newline outside of a message: ends non-JSON input, otherwise just a separator
+                size_t end = scan;
+                while (end > start && (buffer[end - 1] == '\r' || buffer[end - 1] == ' ' || buffer[end - 1] == '\t')) end--;
+                if (end > start) {
+                    frame.assign(buffer, start, end - start);
+                    consume(scan + 1);
+                    return Result::FRAME;
+                }
+                consume(scan + 1);
+                continue;
+            }
+            if ((c == ' ' || c == '\t' || c == '\r') && scan == start) {
+                consume(scan + 1);
+                continue;
+            }
+            if (c == '{' || c == '[') depth = 1;
+        } else if (inString) {
+            if (escape) {
+                escape = false;
+            } else if (c == '\\') {
+                escape = true;
+            } else if (c == '"') {
+                inString = false;
+            }
+        } else if (c == '"') {
+            inString = true;
+        } else if (c == '{' || c == '[') {
+            depth++;
+        } else if (c == '}' || c == ']') {
+            if (--depth == 0) {
+                frame.assign(buffer, start, scan + 1 - start);
+                consume(scan + 1);
+                return Result::FRAME;
+            }
+        }
+
+        scan++;
+        if (scan - start > MAX_FRAME_SIZE) return Result::ERROR;
+    }
+    return Result::INCOMPLETE;
+}
+
+FrameDecoder::Result FrameDecoder::nextLengthPrefixed(std::string& frame) {
+    size_t available = buffer.size() - start;
+    if (available < 4) return Result::INCOMPLETE;
+
+    const unsigned char* header = reinterpret_cast<const unsigned char*>(buffer.data() + start);
+    size_t length = (static_cast<size_t>(header[0]) << 24) | (static_cast<size_t>(header[1]) << 16) |
+                    (static_cast<size_t>(header[2]) << 8) | header[3];
+    if (length > MAX_FRAME_SIZE) return Result::ERROR;
+    if (available < 4 + length) return Result::INCOMPLETE;
+
+    frame.assign(buffer, start + 4, length);
+    consume(start + 4 + length);
+    return Result::FRAME;
+}
+
+void FrameDecoder::consume(size_t end) {
+    start = scan = end;
+    depth = 0;
+    inString = false;
+    escape = false;
+
+    if (start == buffer.size()) {
+        buffer.clear();
+        start = scan = 0;
+    } else if (start > COMPACT_THRESHOLD && start > buffer.size() / 2) {
+        buffer.erase(0, start);
+        start = scan = 0;
+    }
+}
+
+FramingMode FrameDecoder::getMode() const {
+    return mode;
+}
+
+size_t FrameDecoder::getBufferedBytes() const {
+    return buffer.size() - start;
+}
+
+std::string encodeFrame(FramingMode mode, const std::string& payload) {
+    if (mode != FramingMode::LENGTH_PREFIXED) return payload + "\n";
+
+    std::string frame;
+    frame.reserve(4 + payload.size());
+    uint32_t length = static_cast<uint32_t>(payload.size());
+    frame.push_back(static_cast<char>(length >> 24));
+    frame.push_back(static_cast<char>(length >> 16));
+    frame.push_back(static_cast<char>(length >> 8));
+    frame.push_back(static_cast<char>(length));
+    frame += payload;
+    return frame;
+}
@@ -0,0 +1,53 @@
+#ifndef DRONE_MESSAGE_FRAMING_H
+#define DRONE_MESSAGE_FRAMING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Framing of the Connector protocol. The mode is picked from the first byte a client sends:
+//  - JSON text: '{' (or whitespace) starts JSON messages. A message ends with its closing brace or
+//    with a newline, so newline-delimited JSON, back to back objects and the former unterminated
+//    single commands all work. Responses are newline terminated.
+//  - Length-prefixed: a 0x00 byte starts binary frames, each a 4 byte big-endian payload length
+//    followed by the payload. Payloads above 16 MB are never valid, so the first byte is always 0x00.
+enum class FramingMode { DETECT, JSON_TEXT, LENGTH_PREFIXED };
+
+// Incremental frame decoder for one connection. Bytes are appended as they arrive, complete frames
+// are taken out with next(). Partial frames stay buffered, every byte is scanned only once.
+class FrameDecoder {
+public:
+    static constexpr size_t MAX_FRAME_SIZE = 64 * 1024;
+
+    enum class Result { FRAME, INCOMPLETE, ERROR };
+
+    FrameDecoder();
+
+    void append(const char* data, size_t length);
+
+    // Next complete frame. ERROR means the stream is broken (oversized or malformed frame)
+    // and the connection should be closed; the decoder stays in the error state.
+    Result next(std::string& frame);
+
+    FramingMode getMode() const;
+    size_t getBufferedBytes() const;
+
+private:
+    FramingMode mode;
+    std::string buffer;
+    size_t start;       // First byte of the current frame
+    size_t scan;        // Next byte to scan (JSON text mode)
+    int depth;          // Brace/bracket nesting outside of strings
+    bool inString;
+    bool escape;
+    bool failed;
+
+    Result nextJson(std::string& frame);
+    Result nextLengthPrefixed(std::string& frame);
+    void consume(size_t end);
+};
+
+// Wrap an encoded message into a frame of the given mode
+std::string encodeFrame(FramingMode mode, const std::string& payload);
+
+#endif // DRONE_MESSAGE_FRAMING_H
@@ -0,0 +1,57 @@
+#include "Mission.h"
+
+constexpr size_t Mission::MAX_WAYPOINTS;
+
+Mission::Mission() {
+    waypoints.reserve(MAX_WAYPOINTS);
+    legs.reserve(MAX_WAYPOINTS);
+}
+
+void Mission::plan(std::vector<Waypoint> &new_waypoints, const GeoPosition &start, float start_heading,
+                   const TrajectoryLimits &limits) {
+    waypoints.swap(new_waypoints);
+    legs.clear();
+    mission_frame.set_origin(start);
+
+    // Each leg starts where the previous waypoint ends, the first one at the current position
+    EnuPoint leg_start = {0.0, 0.0, 0.0f};
+    float leg_start_heading = start_heading;
+    for (const Waypoint &waypoint : waypoints) {
+        MissionLeg leg;
+        leg.start = leg_start;
+        leg.end = mission_frame.to_enu(waypoint.position);
+        leg.start_heading = leg_start_heading;
+        leg.end_heading = waypoint.heading;
+        leg.trajectory = Trajectory::compile(leg.start, leg.end, leg.start_heading, leg.end_heading,
+                                             waypoint.speed, waypoint.altitude_speed, waypoint.yaw_speed, limits);
+        legs.push_back(leg);
+
+        leg_start = leg.end;
+        leg_start_heading = waypoint.heading;
+    }
+}
+
+void Mission::clear() {
+    waypoints.clear();
+    legs.clear();
+}
+
+size_t Mission::size() const {
+    return legs.size();
+}
+
+bool Mission::empty() const {
+    return legs.empty();
+}
+
+const Waypoint &Mission::waypoint(size_t index) const {
+    return waypoints[index];
+}
+
+const MissionLeg &Mission::leg(size_t index) const {
+    return legs[index];
+}
+
+const LocalFrame &Mission::frame() const {
+    return mission_frame;
+}
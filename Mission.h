@@ -0,0 +1,55 @@
+#ifndef DRONE_MISSION_H
+#define DRONE_MISSION_H
+
+#include <cstddef>
+#include <vector>
+#include "Geodesy.h"
+#include "Trajectory.h"
+
+// Waypoint as uploaded with set_target() or the MISSION command
+struct Waypoint {
+    GeoPosition position;
+    float heading;          // Degrees [0, 360]
+    float speed;            // Horizontal speed (km/h)
+    float altitude_speed;   // Climb/sink speed (km/h)
+    float yaw_speed;        // Rotation speed (degrees/s)
+    float hold_time;        // Seconds to hold at the waypoint before the next leg starts
+};
+
+// One leg in the mission frame, compiled once when the mission starts
+struct MissionLeg {
+    EnuPoint start;
+    EnuPoint end;
+    float start_heading;        // Degrees
+    float end_heading;
+    Trajectory trajectory;      // Temporary target over time, flown with the waypoint's speeds
+};
+
+// Ordered list of waypoints, planned into legs in a local frame anchored at the start position.
+// Storage is reserved for MAX_WAYPOINTS up front, planning a mission does not allocate.
+class Mission {
+public:
+    static constexpr size_t MAX_WAYPOINTS = 64;
+
+    Mission();
+
+    // Take over the waypoints (swapped, the argument receives the former ones) and plan the legs
+    // starting at the current position and heading, with the temporary target moving within <limits>
+    void plan(std::vector<Waypoint> &waypoints, const GeoPosition &start, float start_heading,
+              const TrajectoryLimits &limits);
+
+    void clear();
+
+    size_t size() const;
+    bool empty() const;
+    const Waypoint &waypoint(size_t index) const;
+    const MissionLeg &leg(size_t index) const;
+    const LocalFrame &frame() const;
+
+private:
+    std::vector<Waypoint> waypoints;
+    std::vector<MissionLeg> legs;
+    LocalFrame mission_frame;
+};
+
+#endif // DRONE_MISSION_H
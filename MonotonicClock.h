@@ -0,0 +1,17 @@
+#ifndef DRONE_MONOTONIC_CLOCK_H
+#define DRONE_MONOTONIC_CLOCK_H
+
+#include <cstdint>
+#include <time.h>
+
+// Time base of the whole controller: CLOCK_MONOTONIC in nanoseconds, which is also what
+// std::chrono::steady_clock reads on Linux. Sample timestamps, control ticks, the Scheduler's
+// absolute wake-ups, connection timeouts and SBUS packet arrival times all come from this clock,
+// so times taken in different modules can be compared and subtracted.
+inline int64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+#endif // DRONE_MONOTONIC_CLOCK_H
@@ -0,0 +1,121 @@
+#include "MotionProfile.h"
+#include <cmath>
+#include <limits>
+
+MotionProfile::MotionProfile()
+    : distance(0.0), peak_velocity(0.0), jerk(0.0), acceleration(0.0), jerk_time(0.0), acceleration_time(0.0),
+      cruise_end(0.0), duration(0.0), jerk_end_position(0.0), jerk_end_velocity(0.0), constant_end_position(0.0),
+      constant_end_velocity(0.0), ramp_distance(0.0) {}
+
+MotionProfile::MotionProfile(double distance, double velocity, const MotionLimits &limits) : MotionProfile() {
+    this->distance = distance > 0.0 ? distance : 0.0;
+    if (this->distance == 0.0) return;
+    if (velocity <= 0.0) {
+        duration = std::numeric_limits<double>::infinity();
+        cruise_end = duration;
+        return;
+    }
+
+    double max_acceleration = limits.acceleration > 0.0 ? limits.acceleration : 0.0;
+    jerk = max_acceleration > 0.0 && limits.jerk > 0.0 ? limits.jerk : 0.0;
+
+    plan_ramp(velocity, max_acceleration);
+    if (2.0 * ramp_distance > this->distance) {
+        // Too short to reach the velocity limit: the peak where acceleration and deceleration meet
+        // solves peak * acceleration_time(peak) = distance
+        double peak;
+        if (jerk == 0.0) {
+            peak = std::sqrt(this->distance * max_acceleration);
+        } else {
+            double a = max_acceleration;
+            double ratio = a / jerk;
+            peak = a / 2.0 * (-ratio + std::sqrt(ratio * ratio + 4.0 * this->distance / a));
+            // Below a^2/j the acceleration limit is never reached, the ramp is jerk phases only
+            if (peak < a * ratio) peak = std::cbrt(this->distance * this->distance * jerk / 4.0);
+        }
+        plan_ramp(peak, max_acceleration);
+    }
+
+    cruise_end = acceleration_time + (this->distance - 2.0 * ramp_distance) / peak_velocity;
+    if (cruise_end < acceleration_time) cruise_end = acceleration_time;
+    duration = cruise_end + acceleration_time;
+}
+
+void MotionProfile::plan_ramp(double velocity, double max_acceleration) {
+    peak_velocity = velocity;
+    double constant_time;
+    if (max_acceleration == 0.0) {
+        jerk_time = constant_time = 0.0;
+        acceleration = 0.0;
+    } else if (jerk == 0.0) {
+        jerk_time = 0.0;
+        constant_time = velocity / max_acceleration;
+        acceleration = max_acceleration;
+    } else if (velocity >= max_acceleration * max_acceleration / jerk) {
+        jerk_time = max_acceleration / jerk;
+        constant_time = velocity / max_acceleration - jerk_time;
+        acceleration = max_acceleration;
+    } else {
+        jerk_time = std::sqrt(velocity / jerk);
+        constant_time = 0.0;
+        acceleration = jerk * jerk_time;
+    }
+
+    acceleration_time = 2.0 * jerk_time + constant_time;
+    jerk_end_velocity = jerk * jerk_time * jerk_time / 2.0;
+    jerk_end_position = jerk * jerk_time * jerk_time * jerk_time / 6.0;
+    constant_end_velocity = jerk_end_velocity + acceleration * constant_time;
+    constant_end_position = jerk_end_position + jerk_end_velocity * constant_time +
+                            acceleration * constant_time * constant_time / 2.0;
+    // Symmetric ramp, the average velocity is half the peak
+    ramp_distance = velocity * acceleration_time / 2.0;
+}
+
+void MotionProfile::evaluate_ramp(double t, double &position, double &velocity) const {
+    if (t < jerk_time) {
+        velocity = jerk * t * t / 2.0;
+        position = jerk * t * t * t / 6.0;
+        return;
+    }
+    double constant_time = acceleration_time - 2.0 * jerk_time;
+    if (t < jerk_time + constant_time) {
+        double tau = t - jerk_time;
+        velocity = jerk_end_velocity + acceleration * tau;
+        position = jerk_end_position + jerk_end_velocity * tau + acceleration * tau * tau / 2.0;
+        return;
+    }
+    double tau = t - jerk_time - constant_time;
+    velocity = constant_end_velocity + acceleration * tau - jerk * tau * tau / 2.0;
+    position = constant_end_position + constant_end_velocity * tau + acceleration * tau * tau / 2.0 -
+               jerk * tau * tau * tau / 6.0;
+}
+
+void MotionProfile::evaluate(double t, double &position, double &velocity) const {
+    if (t <= 0.0) {
+        position = velocity = 0.0;
+    } else if (t >= duration) {
+        position = distance;
+        velocity = 0.0;
+    } else if (t < acceleration_time) {
+        evaluate_ramp(t, position, velocity);
+    } else if (t <= cruise_end) {
+        position = ramp_distance + peak_velocity * (t - acceleration_time);
+        velocity = peak_velocity;
+    } else {
+        // The deceleration mirrors the acceleration in time
+        evaluate_ramp(duration - t, position, velocity);
+        position = distance - position;
+    }
+}
+
+double MotionProfile::get_distance() const {
+    return distance;
+}
+
+double MotionProfile::get_peak_velocity() const {
+    return peak_velocity;
+}
+
+double MotionProfile::get_duration() const {
+    return duration;
+}
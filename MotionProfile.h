@@ -0,0 +1,48 @@
+#ifndef DRONE_MOTION_PROFILE_H
+#define DRONE_MOTION_PROFILE_H
+
+// Acceleration and jerk limits of one axis. A limit <= 0 means unlimited: without a jerk limit
+// the profile is trapezoidal, without an acceleration limit it is a constant velocity ramp.
+struct MotionLimits {
+    double acceleration;    // Units/s^2
+    double jerk;            // Units/s^3
+};
+
+// Rest-to-rest move over a distance with velocity, acceleration and jerk limits (S-curve). The
+// acceleration and deceleration phases are symmetric: jerk up, constant acceleration, jerk down,
+// then cruise at the peak velocity. Short moves that cannot reach the velocity limit get a lower
+// peak. Everything is solved when the profile is built, evaluating it is constant time.
+class MotionProfile {
+public:
+    MotionProfile();
+    MotionProfile(double distance, double velocity, const MotionLimits &limits);
+
+    // Travelled distance and velocity <t> seconds after the start, clamped to [0, duration]
+    void evaluate(double t, double &position, double &velocity) const;
+
+    double get_distance() const;
+    double get_peak_velocity() const;
+    double get_duration() const;    // Infinite if the distance is never covered (velocity 0)
+
+private:
+    double distance;
+    double peak_velocity;
+    double jerk;                // 0 without a jerk limit
+    double acceleration;        // Reached acceleration, below the limit on short moves
+    double jerk_time;           // Duration of each jerk phase
+    double acceleration_time;   // Duration of the complete acceleration phase
+    double cruise_end;          // Time the deceleration starts
+    double duration;
+
+    // State at the ends of the first jerk phase and the constant acceleration phase
+    double jerk_end_position;
+    double jerk_end_velocity;
+    double constant_end_position;
+    double constant_end_velocity;
+    double ramp_distance;       // Distance covered while accelerating
+
+    void plan_ramp(double velocity, double max_acceleration);
+    void evaluate_ramp(double t, double &position, double &velocity) const;
+};
+
+#endif // DRONE_MOTION_PROFILE_H
@@ -0,0 +1,116 @@
+#include "NmeaBuffer.h"
+#include <cstring>
+
+static_assert((NmeaLineSplitter::RING_SIZE & (NmeaLineSplitter::RING_SIZE - 1)) == 0, "RING_SIZE must be a power of two");
+
+constexpr size_t NmeaLineSplitter::RING_SIZE;
+constexpr size_t NmeaLineSplitter::MAX_LINE_LENGTH;
+constexpr size_t NmeaSentenceQueue::SLOT_COUNT;
+constexpr size_t NmeaSentenceQueue::SLOT_SIZE;
+
+NmeaLineSplitter::NmeaLineSplitter() : head(0), scan(0), line_start(0), discarding(false), discarded_lines(0) {}
+
+char *NmeaLineSplitter::write_ptr(size_t &capacity) {
+    // Unfinished lines never exceed MAX_LINE_LENGTH, so there is always room left
+    size_t free_space = RING_SIZE - (head - line_start);
+    size_t to_end = RING_SIZE - (head & MASK);
+    capacity = free_space < to_end ? free_space : to_end;
+    return ring + (head & MASK);
+}
+
+void NmeaLineSplitter::commit(size_t count) {
+    head += count;
+}
+
+bool NmeaLineSplitter::next_line(NmeaLine &line) {
+    while (scan != head) {
+        char c = ring[scan & MASK];
+        size_t pos = scan++;
+
+        if (c != '\n') {
+            if (!discarding && pos - line_start >= MAX_LINE_LENGTH) {
+                discarding = true;
+                discarded_lines++;
+            }
+            continue;
+        }
+
+        size_t start = line_start;
+        size_t end = pos;
+        line_start = scan;
+
+        if (discarding) {
+            discarding = false;
+            continue;
+        }
+
+        if (end > start && ring[(end - 1) & MASK] == '\r') end--;
+
+        size_t length = end - start;
+        size_t first_offset = start & MASK;
+        size_t to_end = RING_SIZE - first_offset;
+        line.first = ring + first_offset;
+        line.first_length = length < to_end ? length : to_end;
+        line.second = ring;
+        line.second_length = length - line.first_length;
+        return true;
+    }
+
+    // Drop the bytes of a discarded line so they do not hold space in the ring
+    if (discarding) line_start = scan;
+    return false;
+}
+
+uint64_t NmeaLineSplitter::get_discarded_lines() const {
+    return discarded_lines;
+}
+
+NmeaSentenceQueue::NmeaSentenceQueue() : head(0), count(0), dropped(0) {
+    memset(lengths, 0, sizeof(lengths));
+    memset(timestamps, 0, sizeof(timestamps));
+}
+
+NmeaSentence NmeaSentenceQueue::stage(const NmeaLine &line, int64_t timestamp_ns) {
+    // One slot is always kept free for staging, so a staged sentence never overwrites a queued one
+    size_t index = (head + count) % SLOT_COUNT;
+    char *slot = slots[index];
+    size_t length = line.length();
+    if (length > SLOT_SIZE - 1) length = SLOT_SIZE - 1;
+
+    size_t first_length = line.first_length < length ? line.first_length : length;
+    memcpy(slot, line.first, first_length);
+    memcpy(slot + first_length, line.second, length - first_length);
+    slot[length] = '\0';
+    lengths[index] = length;
+    timestamps[index] = timestamp_ns;
+
+    NmeaSentence sentence = {slot, length, timestamp_ns};
+    return sentence;
+}
+
+void NmeaSentenceQueue::push() {
+    if (count == SLOT_COUNT - 1) {
+        head = (head + 1) % SLOT_COUNT;
+        count--;
+        dropped++;
+    }
+    count++;
+}
+
+bool NmeaSentenceQueue::pop(NmeaSentence &sentence) {
+    if (count == 0) return false;
+    sentence.data = slots[head];
+    sentence.length = lengths[head];
+    sentence.timestamp_ns = timestamps[head];
+    head = (head + 1) % SLOT_COUNT;
+    count--;
+    return true;
+}
+
+size_t NmeaSentenceQueue::size() const {
+    return count;
+}
+
+uint64_t NmeaSentenceQueue::get_dropped() const {
+    return dropped;
+}
@@ -0,0 +1,85 @@
+#ifndef DRONE_NMEA_BUFFER_H
+#define DRONE_NMEA_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Read-only view of a sentence stored in a NmeaSentenceQueue slot (null-terminated)
+struct NmeaSentence {
+    const char *data;
+    size_t length;
+    int64_t timestamp_ns;   // monotonic_ns() time the sentence was received
+};
+
+// Line in the splitter ring, split in two parts when it wraps around the end of the ring
+struct NmeaLine {
+    const char *first;
+    size_t first_length;
+    const char *second;
+    size_t second_length;
+
+    size_t length() const { return first_length + second_length; }
+};
+
+// Splits the raw serial byte stream into lines on a fixed ring buffer.
+// Bytes are read directly into the ring, lines are handed out without copying.
+class NmeaLineSplitter {
+public:
+    static constexpr size_t RING_SIZE = 4096;       // Must be a power of two
+    static constexpr size_t MAX_LINE_LENGTH = 120;  // Longer lines are garbage and get discarded
+
+    NmeaLineSplitter();
+
+    // Contiguous free space to read into, capacity is set to its size
+    char *write_ptr(size_t &capacity);
+
+    // Make <count> bytes written to write_ptr() available for splitting
+    void commit(size_t count);
+
+    // Next complete line without the line ending, valid until the next commit()
+    bool next_line(NmeaLine &line);
+
+    uint64_t get_discarded_lines() const;
+
+private:
+    char ring[RING_SIZE];
+    size_t head;        // Write position (monotonic, wrapped with the mask)
+    size_t scan;        // Next byte to look for a line ending
+    size_t line_start;  // First byte of the current line
+    bool discarding;    // Current line is too long and is skipped up to the next line ending
+    uint64_t discarded_lines;
+
+    static constexpr size_t MASK = RING_SIZE - 1;
+};
+
+// Fixed pool of sentence slots used as a bounded FIFO. When full the oldest sentence is dropped.
+// Not synchronized, the owner serializes access.
+class NmeaSentenceQueue {
+public:
+    static constexpr size_t SLOT_COUNT = 16;
+    static constexpr size_t SLOT_SIZE = NmeaLineSplitter::MAX_LINE_LENGTH + 1;
+
+    NmeaSentenceQueue();
+
+    // Copy a line into the next free slot (null-terminated), it is queued with push()
+    NmeaSentence stage(const NmeaLine &line, int64_t timestamp_ns);
+
+    // Queue the sentence written by stage()
+    void push();
+
+    // Oldest queued sentence, valid until it is overwritten by later stage() calls
+    bool pop(NmeaSentence &sentence);
+
+    size_t size() const;
+    uint64_t get_dropped() const;
+
+private:
+    char slots[SLOT_COUNT][SLOT_SIZE];
+    size_t lengths[SLOT_COUNT];
+    int64_t timestamps[SLOT_COUNT];
+    size_t head;    // Oldest queued slot
+    size_t count;   // Number of queued slots
+    uint64_t dropped;
+};
+
+#endif // DRONE_NMEA_BUFFER_H
@@ -0,0 +1,186 @@
+#include "NmeaParser.h"
+#include <cstdint>
+#include <cstring>
+
+static const int64_t POW10[] = {
+    1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL, 100000000LL, 1000000000LL,
+    10000000000LL, 100000000000LL, 1000000000000LL, 10000000000000LL, 100000000000000LL,
+    1000000000000000LL, 10000000000000000LL, 100000000000000000LL,
+};
+static const int MAX_DIGITS = 17;
+
+NmeaTokenizer::NmeaTokenizer(const NmeaSentence &sentence)
+    : pos(sentence.data), end(sentence.data + sentence.length), done(false) {
+    if (pos < end && *pos == '$') ++pos;
+    const char *checksum = static_cast<const char *>(memchr(pos, '*', end - pos));
+    if (checksum != nullptr) end = checksum;
+}
+
+bool NmeaTokenizer::next(NmeaField &field) {
+    if (done) return false;
+
+    const char *comma = static_cast<const char *>(memchr(pos, ',', end - pos));
+    field.data = pos;
+    if (comma == nullptr) {
+        // Last field
+        field.length = end - pos;
+        done = true;
+    } else {
+        field.length = comma - pos;
+        pos = comma + 1;
+    }
+    return true;
+}
+
+bool NmeaParser::parse_int(const NmeaField &field, int &value) {
+    if (field.empty() || field.length > 9) return false;
+    int result = 0;
+    for (size_t i = 0; i < field.length; ++i) {
+        char c = field.data[i];
+        if (c < '0' || c > '9') return false;
+        result = result * 10 + (c - '0');
+    }
+    value = result;
+    return true;
+}
+
+bool NmeaParser::parse_decimal(const NmeaField &field, double &value) {
+    if (field.empty()) return false;
+
+    size_t i = 0;
+    bool negative = false;
+    if (field.data[0] == '-' || field.data[0] == '+') {
+        negative = field.data[0] == '-';
+        i = 1;
+    }
+
+    int64_t mantissa = 0;
+    int digits = 0;
+    int fraction_digits = 0;
+    bool fraction = false;
+    for (; i < field.length; ++i) {
+        char c = field.data[i];
+        if (c == '.' && !fraction) {
+            fraction = true;
+        } else if (c >= '0' && c <= '9') {
+            // Digits beyond the int64 range are below float/double resolution for NMEA values
+            if (digits >= MAX_DIGITS) {
+                if (!fraction) return false;
+                continue;
+            }
+            mantissa = mantissa * 10 + (c - '0');
+            digits++;
+            if (fraction) fraction_digits++;
+        } else {
+            return false;
+        }
+    }
+    if (digits == 0) return false;
+
+    double result = static_cast<double>(mantissa) / POW10[fraction_digits];
+    value = negative ? -result : result;
+    return true;
+}
+
+bool NmeaParser::parse_coordinate(const NmeaField &coord, const NmeaField &hemisphere, double &decimal) {
+    if (coord.empty() || hemisphere.length != 1) return false;
+    char direction = hemisphere.data[0];
+    if (!(direction == 'N' || direction == 'S' || direction == 'E' || direction == 'W')) return false;
+
+    // (d)ddmm as one integer: degrees are everything above the last two digits
+    size_t i = 0;
+    int64_t whole = 0;
+    int whole_digits = 0;
+    for (; i < coord.length && coord.data[i] != '.'; ++i) {
+        char c = coord.data[i];
+        if (c < '0' || c > '9' || whole_digits >= 5) return false;
+        whole = whole * 10 + (c - '0');
+        whole_digits++;
+    }
+    if (whole_digits < 3) return false;
+
+    // Fraction of minutes as integer with its scale
+    int64_t fraction = 0;
+    int fraction_digits = 0;
+    if (i < coord.length) {
+        for (++i; i < coord.length; ++i) {
+            char c = coord.data[i];
+            if (c < '0' || c > '9') return false;
+            if (fraction_digits >= 10) continue;  // Far below a millimeter
+            fraction = fraction * 10 + (c - '0');
+            fraction_digits++;
+        }
+    }
+
+    int64_t degrees = whole / 100;
+    int64_t minutes = whole % 100;
+    if (minutes >= 60) return false;
+
+    // degrees + (minutes + fraction / 10^k) / 60, rounded only once
+    int64_t scale = POW10[fraction_digits];
+    int64_t scaled_minutes = minutes * scale + fraction;
+    double result = static_cast<double>(degrees) + static_cast<double>(scaled_minutes) / static_cast<double>(60 * scale);
+
+    if (direction == 'S' || direction == 'W') result = -result;
+    decimal = result;
+    return true;
+}
+
+bool NmeaParser::copy_time(const NmeaField &field, char (&time)[11]) {
+    if (field.empty() || field.length >= sizeof(time)) return false;
+    memcpy(time, field.data, field.length);
+    time[field.length] = '\0';
+    return true;
+}
+
+bool NmeaParser::parse_rmc(const NmeaSentence &sentence, NmeaRmc &rmc) {
+    NmeaTokenizer tokenizer(sentence);
+    NmeaField fields[9];
+    size_t count = 0;
+    while (count < 9 && tokenizer.next(fields[count])) count++;
+
+    // address, time, status, lat, N/S, lon, E/W, speed, course
+    if (count < 9 || fields[0].length != 5 || strncmp(fields[0].data + 2, "RMC", 3) != 0) return false;
+
+    if (!copy_time(fields[1], rmc.time)) return false;
+    rmc.active = fields[2].length == 1 && fields[2].data[0] == 'A';
+    if (!rmc.active) return true;
+
+    if (!parse_coordinate(fields[3], fields[4], rmc.latitude)) return false;
+    if (!parse_coordinate(fields[5], fields[6], rmc.longitude)) return false;
+
+    // Speed and course are left empty by some receivers while standing still
+    double value;
+    rmc.speed = parse_decimal(fields[7], value) ? static_cast<float>(value) : 0.0f;
+    rmc.course = parse_decimal(fields[8], value) ? static_cast<float>(value) : 0.0f;
+    return true;
+}
+
+bool NmeaParser::parse_gga(const NmeaSentence &sentence, NmeaGga &gga) {
+    NmeaTokenizer tokenizer(sentence);
+    NmeaField fields[12];
+    size_t count = 0;
+    while (count < 12 && tokenizer.next(fields[count])) count++;
+
+    // address, time, lat, N/S, lon, E/W, fix, satellites, hdop, altitude, M, geoid
+    if (count < 12 || fields[0].length != 5 || strncmp(fields[0].data + 2, "GGA", 3) != 0) return false;
+
+    if (!copy_time(fields[1], gga.time)) return false;
+    if (!parse_int(fields[6], gga.fix_quality)) return false;
+    if (!parse_int(fields[7], gga.satellites)) gga.satellites = 0;
+
+    double value;
+    gga.hdop = parse_decimal(fields[8], value) ? static_cast<float>(value) : 0.0f;
+
+    // Without a fix the position fields are empty, fix quality and satellites are still valid
+    gga.has_position = false;
+    if (fields[2].empty() || fields[4].empty()) return true;
+
+    if (!parse_coordinate(fields[2], fields[3], gga.latitude)) return false;
+    if (!parse_coordinate(fields[4], fields[5], gga.longitude)) return false;
+    if (!parse_decimal(fields[9], value)) return false;
+    gga.altitude = static_cast<float>(value);
+    gga.geoid = parse_decimal(fields[11], value) ? static_cast<float>(value) : 0.0f;
+    gga.has_position = true;
+    return true;
+}
@@ -0,0 +1,75 @@
+#ifndef DRONE_NMEA_PARSER_H
+#define DRONE_NMEA_PARSER_H
+
+#include <cstddef>
+#include "NmeaBuffer.h"
+
+// Field of a sentence, points into the sentence buffer
+struct NmeaField {
+    const char *data;
+    size_t length;
+
+    bool empty() const { return length == 0; }
+};
+
+// Walks the comma separated fields of a sentence in place, stops at the checksum
+class NmeaTokenizer {
+public:
+    explicit NmeaTokenizer(const NmeaSentence &sentence);
+
+    // Next field, the first one is the address ("GNRMC")
+    bool next(NmeaField &field);
+
+private:
+    const char *pos;
+    const char *end;
+    bool done;
+};
+
+// Recommended minimum data ($xxRMC)
+struct NmeaRmc {
+    char time[11];      // hhmmss.sss
+    bool active;        // Status 'A', otherwise the fix is void
+    double latitude;    // Decimal degrees
+    double longitude;   // Decimal degrees
+    float speed;        // Speed over ground (knots)
+    float course;       // Course over ground (degrees)
+};
+
+// Fix data ($xxGGA)
+struct NmeaGga {
+    char time[11];      // hhmmss.sss
+    bool has_position;  // False when the receiver has no fix and leaves the position fields empty
+    double latitude;    // Decimal degrees
+    double longitude;   // Decimal degrees
+    int fix_quality;
+    int satellites;
+    float hdop;
+    float altitude;     // Above mean sea level (meters)
+    float geoid;        // Geoid separation (meters)
+};
+
+// Allocation and exception free parser for the sentences used by the GPS module
+class NmeaParser {
+public:
+    // Parse a checksum validated $xxRMC sentence, returns false if a required field is missing or malformed
+    static bool parse_rmc(const NmeaSentence &sentence, NmeaRmc &rmc);
+
+    // Parse a checksum validated $xxGGA sentence, returns false if a required field is missing or malformed
+    static bool parse_gga(const NmeaSentence &sentence, NmeaGga &gga);
+
+    // Convert a (d)ddmm.mmmm coordinate with hemisphere to decimal degrees, using integer arithmetic
+    // up to the final division so no precision is lost to float parsing
+    static bool parse_coordinate(const NmeaField &coord, const NmeaField &hemisphere, double &decimal);
+
+    // Parse a decimal number like "-12.345"
+    static bool parse_decimal(const NmeaField &field, double &value);
+
+    // Parse an unsigned integer
+    static bool parse_int(const NmeaField &field, int &value);
+
+private:
+    static bool copy_time(const NmeaField &field, char (&time)[11]);
+};
+
+#endif // DRONE_NMEA_PARSER_H
@@ -0,0 +1,264 @@
+#include "ParameterStore.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+typedef ParameterStore::Descriptor::Type Type;
+
+#define PARAMETER(name, type, field, min, max) {name, type, offsetof(ControlParameters, field), min, max}
+#define PID_PARAMETERS(axis, index)                                                            \
+    PARAMETER("pid." axis ".kp", Type::FLOAT, gains[index].kp, 0.0, 1000.0),                   \
+    PARAMETER("pid." axis ".ki", Type::FLOAT, gains[index].ki, 0.0, 1000.0),                   \
+    PARAMETER("pid." axis ".kd", Type::FLOAT, gains[index].kd, 0.0, 1000.0),                   \
+    PARAMETER("pid." axis ".kff", Type::FLOAT, gains[index].kff, 0.0, 1000.0),                 \
+    PARAMETER("pid." axis ".derivative_cutoff", Type::FLOAT, gains[index].derivative_cutoff, 0.0, 50.0)
+
+static const ParameterStore::Descriptor DESCRIPTORS[] = {
+    PID_PARAMETERS("roll", 0),
+    PID_PARAMETERS("pitch", 1),
+    PID_PARAMETERS("throttle", 2),
+    PID_PARAMETERS("yaw", 3),
+    PARAMETER("threshold.distance", Type::FLOAT, distance_threshold, 0.1, 100.0),
+    PARAMETER("threshold.altitude", Type::FLOAT, altitude_threshold, 0.1, 100.0),
+    PARAMETER("threshold.heading", Type::FLOAT, heading_threshold, 0.1, 180.0),
+    PARAMETER("limits.horizontal.acceleration", Type::DOUBLE, limits.horizontal.acceleration, 0.0, 50.0),
+    PARAMETER("limits.horizontal.jerk", Type::DOUBLE, limits.horizontal.jerk, 0.0, 500.0),
+    PARAMETER("limits.vertical.acceleration", Type::DOUBLE, limits.vertical.acceleration, 0.0, 50.0),
+    PARAMETER("limits.vertical.jerk", Type::DOUBLE, limits.vertical.jerk, 0.0, 500.0),
+    PARAMETER("limits.yaw.acceleration", Type::DOUBLE, limits.yaw.acceleration, 0.0, 3600.0),
+    PARAMETER("limits.yaw.jerk", Type::DOUBLE, limits.yaw.jerk, 0.0, 36000.0),
+    PARAMETER("sensors.gps_max_age_ms", Type::INT64, gps_max_age_ms, 100.0, 10000.0),
+    PARAMETER("sensors.compass_max_age_ms", Type::INT64, compass_max_age_ms, 20.0, 5000.0),
+    PARAMETER("target.gps_timeout_ms", Type::INT64, target_gps_timeout_ms, 0.0, 600000.0),
+    PARAMETER("sbus.center", Type::INT, sbus_center, 172.0, 1811.0),
+    PARAMETER("sbus.min", Type::INT, sbus_min, 172.0, 1811.0),
+    PARAMETER("sbus.max", Type::INT, sbus_max, 172.0, 1811.0),
+    PARAMETER("rate.udp_telemetry", Type::DOUBLE, udp_telemetry_rate, 0.1, 100.0),
+    PARAMETER("rate.compass", Type::DOUBLE, compass_sample_rate, 10.0, 200.0),
+};
+
+#undef PID_PARAMETERS
+#undef PARAMETER
+
+static ControlParameters default_parameters() {
+    ControlParameters parameters;
+    memset(&parameters, 0, sizeof(parameters));
+
+    // Full stick at 10 m horizontal, 20 m altitude and 90° heading deviation
+    const float proportional[4] = {66.0f, 66.0f, 33.0f, 7.33f};
+    for (size_t axis = 0; axis < 4; ++axis) {
+        parameters.gains[axis] = {proportional[axis], 0.0f, 0.0f, 0.0f, 2.0f};
+    }
+
+    parameters.distance_threshold = 2.0f;
+    parameters.altitude_threshold = 5.0f;
+    parameters.heading_threshold = 5.0f;
+    parameters.limits = {{2.0, 4.0}, {1.0, 2.0}, {45.0, 180.0}};
+
+    parameters.gps_max_age_ms = 2000;       // Covers receivers running at 1 Hz
+    parameters.compass_max_age_ms = 250;
+    parameters.target_gps_timeout_ms = 5000;
+
+    parameters.sbus_center = 1024;
+    parameters.sbus_min = 364;
+    parameters.sbus_max = 1684;
+
+    parameters.udp_telemetry_rate = 10.0;
+    parameters.compass_sample_rate = 100.0;
+    return parameters;
+}
+
+static bool write_value(ControlParameters &parameters, const ParameterStore::Descriptor &descriptor,
+                        const json &value, std::string &error) {
+    if (!value.is_number()) {
+        error = std::string(descriptor.name) + ": not a number";
+        return false;
+    }
+    double number = value.get<double>();
+    if (!std::isfinite(number) || number < descriptor.min || number > descriptor.max) {
+        error = std::string(descriptor.name) + ": out of range";
+        return false;
+    }
+
+    char *field = reinterpret_cast<char *>(&parameters) + descriptor.offset;
+    switch (descriptor.type) {
+        case Type::FLOAT: {
+            float converted = static_cast<float>(number);
+            memcpy(field, &converted, sizeof(converted));
+            break;
+        }
+        case Type::DOUBLE:
+            memcpy(field, &number, sizeof(number));
+            break;
+        case Type::INT: {
+            if (number != std::floor(number)) {
+                error = std::string(descriptor.name) + ": not an integer";
+                return false;
+            }
+            int converted = static_cast<int>(number);
+            memcpy(field, &converted, sizeof(converted));
+            break;
+        }
+        case Type::INT64: {
+            if (number != std::floor(number)) {
+                error = std::string(descriptor.name) + ": not an integer";
+                return false;
+            }
+            int64_t converted = static_cast<int64_t>(number);
+            memcpy(field, &converted, sizeof(converted));
+            break;
+        }
+    }
+    return true;
+}
+
+static json read_value(const ControlParameters &parameters, const ParameterStore::Descriptor &descriptor) {
+    const char *field = reinterpret_cast<const char *>(&parameters) + descriptor.offset;
+    switch (descriptor.type) {
+        case Type::FLOAT: {
+            float value;
+            memcpy(&value, field, sizeof(value));
+            return value;
+        }
+        case Type::DOUBLE: {
+            double value;
+            memcpy(&value, field, sizeof(value));
+            return value;
+        }
+        case Type::INT: {
+            int value;
+            memcpy(&value, field, sizeof(value));
+            return value;
+        }
+        case Type::INT64: {
+            int64_t value;
+            memcpy(&value, field, sizeof(value));
+            return value;
+        }
+    }
+    return nullptr;
+}
+
+// Name sent by a client, for error messages. Anything but printable ASCII is replaced, so the
+// message stays valid UTF-8 whatever the client sent.
+static std::string printable_name(const std::string &name) {
+    static const size_t MAX_LENGTH = 64;
+    std::string printable = name.substr(0, MAX_LENGTH);
+    for (char &c : printable) {
+        if (c < 0x20 || c > 0x7e) c = '?';
+    }
+    if (name.size() > MAX_LENGTH) printable += "...";
+    return printable;
+}
+
+ParameterStore::ParameterStore() : current(default_parameters()) {
+    published.publish(current);
+}
+
+const ParameterStore::Descriptor *ParameterStore::find(const std::string &name) {
+    for (const Descriptor &descriptor : DESCRIPTORS) {
+        if (name == descriptor.name) return &descriptor;
+    }
+    return nullptr;
+}
+
+bool ParameterStore::set(const json &values, std::string &error) {
+    if (!values.is_object()) {
+        error = "parameters must be an object";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(write_mutex);
+    ControlParameters changed = current;
+    for (auto it = values.begin(); it != values.end(); ++it) {
+        const Descriptor *descriptor = find(it.key());
+        if (descriptor == nullptr) {
+            error = printable_name(it.key()) + ": unknown parameter";
+            return false;
+        }
+        if (!write_value(changed, *descriptor, it.value(), error)) return false;
+    }
+    if (!(changed.sbus_min < changed.sbus_center && changed.sbus_center < changed.sbus_max)) {
+        error = "sbus: min < center < max required";
+        return false;
+    }
+
+    current = changed;
+    published.publish(current);
+    return true;
+}
+
+bool ParameterStore::load_file(const std::string &path, std::string &error) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cout << "No parameter file " << path << ", using defaults" << std::endl;
+        std::lock_guard<std::mutex> lock(write_mutex);
+        file_path = path;
+        return true;
+    }
+
+    json values;
+    try {
+        file >> values;
+    } catch (const json::exception &e) {
+        error = path + ": " + e.what();
+        return false;
+    }
+    if (!set(values, error)) {
+        error = path + ": " + error;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(write_mutex);
+    file_path = path;
+    return true;
+}
+
+bool ParameterStore::save_file(const std::string &path, std::string &error) {
+    std::string target;
+    {
+        std::lock_guard<std::mutex> lock(write_mutex);
+        target = path.empty() ? file_path : path;
+    }
+    if (target.empty()) {
+        error = "no parameter file";
+        return false;
+    }
+
+    // Written next to the file and renamed, a crash never leaves a truncated file behind
+    std::string temporary = target + ".tmp";
+    {
+        std::ofstream file(temporary);
+        file << to_json().dump(4) << std::endl;
+        if (!file) {
+            error = "cannot write " + temporary;
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), target.c_str()) != 0) {
+        error = "cannot replace " + target;
+        return false;
+    }
+    return true;
+}
+
+json ParameterStore::to_json() const {
+    ControlParameters parameters = get();
+    json values = json::object();
+    for (const Descriptor &descriptor : DESCRIPTORS) {
+        values[descriptor.name] = read_value(parameters, descriptor);
+    }
+    return values;
+}
+
+ControlParameters ParameterStore::get() const {
+    return published.value();
+}
+
+uint64_t ParameterStore::get_version() const {
+    return published.get_sequence();
+}
@@ -0,0 +1,81 @@
+#ifndef DRONE_PARAMETER_STORE_H
+#define DRONE_PARAMETER_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <nlohmann/json_fwd.hpp>
+#include "LatestSample.h"
+#include "PidController.h"
+#include "Trajectory.h"
+
+// Tunable parameters of the controller, one consistent set. Plain data so it can be published
+// through a LatestSample and copied by the control tick without locking.
+struct ControlParameters {
+    PidGains gains[4];              // Indexed by ControlLoop::ControlAxis
+
+    float distance_threshold;       // Meters, waypoint reached
+    float altitude_threshold;       // Meters
+    float heading_threshold;        // Degrees
+
+    TrajectoryLimits limits;        // Motion limits of the temporary target
+
+    int64_t gps_max_age_ms;         // Older samples are not used for control
+    int64_t compass_max_age_ms;
+    int64_t target_gps_timeout_ms;  // Pending targets are aborted without reliable GPS until then
+
+    int sbus_center;                // SBUS channel values of the steering channels
+    int sbus_min;
+    int sbus_max;
+
+    double udp_telemetry_rate;      // Hz, read at startup
+    double compass_sample_rate;     // Hz, read at startup
+};
+
+// Named, typed parameter store. Parameters have dotted names (e.g. "pid.roll.kp") and a valid range,
+// and are read from and written to flat JSON objects {"name": value, ...}.
+// Writers (file loading, Connector commands) are serialized and change several parameters all or
+// nothing; every change is published as a new snapshot. The control loop picks up new snapshots at
+// the start of a tick, so one tick always works with one consistent set.
+class ParameterStore {
+public:
+    ParameterStore();
+
+    // Apply the parameters of a JSON file. A missing file keeps the current values. Unknown names,
+    // wrong types or out of range values reject the whole file.
+    bool load_file(const std::string &path, std::string &error);
+
+    // Write all parameters to <path>, or to the file loaded last if empty
+    bool save_file(const std::string &path, std::string &error);
+
+    // Change several parameters at once, nothing is changed if any of them is invalid
+    bool set(const nlohmann::json &values, std::string &error);
+
+    // All parameters with their current values
+    nlohmann::json to_json() const;
+
+    // Latest snapshot, lock-free
+    ControlParameters get() const;
+
+    // Incremented with every change, 1 after construction
+    uint64_t get_version() const;
+
+    // Parameter description for listings
+    struct Descriptor {
+        const char *name;
+        enum class Type { FLOAT, DOUBLE, INT, INT64 } type;
+        size_t offset;          // In ControlParameters
+        double min;
+        double max;
+    };
+    static const Descriptor *find(const std::string &name);
+
+private:
+    mutable std::mutex write_mutex;     // Serializes writers, never taken by the control tick
+    ControlParameters current;          // Latest values, guarded by write_mutex
+    std::string file_path;              // File loaded last
+    LatestSample<ControlParameters> published;
+};
+
+#endif // DRONE_PARAMETER_STORE_H
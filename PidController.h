@@ -0,0 +1,112 @@
+#ifndef DRONE_PID_CONTROLLER_H
+#define DRONE_PID_CONTROLLER_H
+
+#include <cmath>
+
+// Gains of one PID axis. Outputs are in the unit of the actuator (e.g. SBUS steps from center).
+struct PidGains {
+    float kp;                   // Per unit of error
+    float ki;                   // Per unit of error and second
+    float kd;                   // Per unit/s of measured rate
+    float kff;                  // Per unit/s of setpoint rate
+    float derivative_cutoff;    // Hz, low-pass on the measured rate, 0 disables the filter
+};
+
+// PID controller for one axis, header-only so the update inlines into the control tick.
+//  - Derivative on measurement: damps the measured rate instead of differentiating the error, so
+//    setpoint steps do not kick the output. The rate comes from the caller (e.g. the state estimator)
+//    and is low-pass filtered.
+//  - Velocity feed-forward: the setpoint rate (e.g. the temporary target's velocity) is added
+//    directly, the feedback part only corrects the remaining error.
+//  - Clamping anti-windup: the integrator stops while the output saturates in the direction of
+//    the error, and never holds more than the output limit on its own.
+class PidController {
+public:
+    PidController() : gains({0.0f, 0.0f, 0.0f, 0.0f, 0.0f}), output_limit(0.0f), filter_time_constant(0.0f) {
+        reset();
+    }
+
+    PidController(const PidGains &gains, float output_limit) : PidController() {
+        set_gains(gains);
+        set_output_limit(output_limit);
+    }
+
+    void set_gains(const PidGains &new_gains) {
+        gains = new_gains;
+        filter_time_constant = gains.derivative_cutoff > 0.0f ? 1.0f / (2.0f * static_cast<float>(M_PI) * gains.derivative_cutoff) : 0.0f;
+        // A smaller ki must not release a larger integral at once
+        clamp_integral();
+    }
+
+    const PidGains &get_gains() const {
+        return gains;
+    }
+
+    // Symmetric output limit, 0 for unlimited
+    void set_output_limit(float limit) {
+        output_limit = std::fabs(limit);
+        clamp_integral();
+    }
+
+    // Drop the integral and the derivative filter, e.g. when a new target starts
+    void reset() {
+        integral = 0.0f;
+        filtered_rate = 0.0f;
+        has_rate = false;
+        last_output = 0.0f;
+    }
+
+    // One control step of <dt> seconds, returns the limited output
+    float update(float error, float measured_rate, float setpoint_rate, float dt) {
+        if (!has_rate || filter_time_constant == 0.0f) {
+            filtered_rate = measured_rate;
+            has_rate = true;
+        } else if (dt > 0.0f) {
+            filtered_rate += dt / (filter_time_constant + dt) * (measured_rate - filtered_rate);
+        }
+
+        float feedback = gains.kp * error - gains.kd * filtered_rate + gains.kff * setpoint_rate;
+        if (dt > 0.0f && gains.ki != 0.0f) {
+            float candidate = integral + gains.ki * error * dt;
+            float output = feedback + candidate;
+            bool saturated_high = output_limit > 0.0f && output > output_limit && error * gains.ki > 0.0f;
+            bool saturated_low = output_limit > 0.0f && output < -output_limit && error * gains.ki < 0.0f;
+            if (!saturated_high && !saturated_low) integral = candidate;
+            clamp_integral();
+        }
+
+        last_output = limit(feedback + integral);
+        return last_output;
+    }
+
+    float get_integral() const {
+        return integral;
+    }
+
+    float get_output() const {
+        return last_output;
+    }
+
+private:
+    PidGains gains;
+    float output_limit;
+    float filter_time_constant;     // Seconds, 0 without filter
+    float integral;                 // Output units
+    float filtered_rate;
+    bool has_rate;
+    float last_output;
+
+    float limit(float value) const {
+        if (output_limit == 0.0f) return value;
+        if (value > output_limit) return output_limit;
+        if (value < -output_limit) return -output_limit;
+        return value;
+    }
+
+    void clamp_integral() {
+        if (gains.ki == 0.0f) integral = 0.0f;
+        integral = limit(integral);
+    }
+};
+
+#endif // DRONE_PID_CONTROLLER_H
@@ -0,0 +1,49 @@
+#ifndef DRONE_RC_INTERFACES_H
+#define DRONE_RC_INTERFACES_H
+
+#include <cstdint>
+#include <functional>
+#include "SBUS.h"
+
+// Interfaces between the control pipeline and the remote control link. SbusRadio uses the SBUS tty of
+// the Raspberry Pi, MemoryBackends.h implements them without hardware.
+
+// Packets of the remote control receiver
+class RcInput {
+public:
+    typedef std::function<void(const sbus_packet_t &)> PacketListener;
+
+    virtual ~RcInput() {}
+
+    virtual bool init() = 0;
+
+    // Called for every received packet on the thread running run(), set before run()
+    virtual void set_packet_listener(PacketListener listener) = 0;
+
+    // Receive packets until stop() is called, false on a fatal error
+    virtual bool run() = 0;
+
+    // Make run() return, safe to call from any thread
+    virtual void stop() = 0;
+
+    // monotonic_ns() arrival time of the packet delivered last, 0 if there was none yet
+    virtual int64_t get_last_packet_ns() const = 0;
+
+    virtual uint64_t get_packet_count() const = 0;
+
+    // Received data that could not be decoded
+    virtual uint64_t get_error_count() const = 0;
+};
+
+// Packets to the flight controller
+class RcOutput {
+public:
+    virtual ~RcOutput() {}
+
+    virtual bool init() = 0;
+
+    // Send one packet, false if it could not be sent
+    virtual bool write(const sbus_packet_t &packet) = 0;
+};
+
+#endif // DRONE_RC_INTERFACES_H
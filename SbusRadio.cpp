@@ -0,0 +1,64 @@
+#include "SbusRadio.h"
+
+std::atomic<SbusRadio *> SbusRadio::installed_radio(nullptr);
+
+SbusRadio::SbusRadio(const std::string &tty_path)
+    : tty_path(tty_path), reactor(sbus), last_error(SBUS_OK), installed(false) {}
+
+SbusRadio::~SbusRadio() {
+    SbusRadio *self = this;
+    installed_radio.compare_exchange_strong(self, nullptr);
+}
+
+bool SbusRadio::init() {
+    installed_radio = this;
+    sbus.onPacket(dispatch_packet);
+
+    last_error = sbus.install(tty_path.c_str(), false);  // non-blocking, the reactor waits for data
+    if (last_error == SBUS_OK) {
+        last_error = reactor.install();
+    }
+    installed = last_error == SBUS_OK;
+    return installed;
+}
+
+sbus_err_t SbusRadio::get_last_error() const {
+    return last_error;
+}
+
+void SbusRadio::set_packet_listener(PacketListener packet_listener) {
+    listener = packet_listener;
+}
+
+void SbusRadio::dispatch_packet(const sbus_packet_t &packet) {
+    SbusRadio *radio = installed_radio.load();
+    if (radio != nullptr && radio->listener) radio->listener(packet);
+}
+
+bool SbusRadio::run() {
+    if (!installed) return false;
+    last_error = reactor.run();
+    return last_error == SBUS_OK;
+}
+
+void SbusRadio::stop() {
+    reactor.stop();
+}
+
+int64_t SbusRadio::get_last_packet_ns() const {
+    struct timespec arrival = reactor.lastPacketTime();
+    return arrival.tv_sec * 1000000000LL + arrival.tv_nsec;
+}
+
+uint64_t SbusRadio::get_packet_count() const {
+    return reactor.packetCount();
+}
+
+uint64_t SbusRadio::get_error_count() const {
+    return reactor.desyncCount();
+}
+
+bool SbusRadio::write(const sbus_packet_t &packet) {
+    if (!installed) return false;
+    return sbus.write(packet) == SBUS_OK;
+}
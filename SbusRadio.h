@@ -0,0 +1,43 @@
+#ifndef DRONE_SBUS_RADIO_H
+#define DRONE_SBUS_RADIO_H
+
+#include <atomic>
+#include <string>
+#include "RcInterfaces.h"
+#include "SbusReactor.h"
+
+// SBUS tty shared by the remote control receiver and the flight controller: packets of the receiver
+// are decoded by an SbusReactor, packets to the flight controller are written to the same tty.
+// The SBUS driver takes a plain function pointer as callback, so only one SbusRadio can be
+// installed at a time.
+class SbusRadio : public RcInput, public RcOutput {
+public:
+    explicit SbusRadio(const std::string &tty_path);
+    ~SbusRadio();
+
+    // Install the tty (non-blocking) and the reactor, error code in get_last_error()
+    bool init() override;
+    sbus_err_t get_last_error() const;
+
+    void set_packet_listener(PacketListener listener) override;
+    bool run() override;
+    void stop() override;
+    int64_t get_last_packet_ns() const override;
+    uint64_t get_packet_count() const override;
+    uint64_t get_error_count() const override;
+
+    bool write(const sbus_packet_t &packet) override;
+
+private:
+    std::string tty_path;
+    SBUS sbus;
+    SbusReactor reactor;
+    PacketListener listener;
+    sbus_err_t last_error;
+    bool installed;
+
+    static std::atomic<SbusRadio *> installed_radio;
+    static void dispatch_packet(const sbus_packet_t &packet);
+};
+
+#endif // DRONE_SBUS_RADIO_H
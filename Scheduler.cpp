@@ -0,0 +1,116 @@
+#include "Scheduler.h"
+#include <cerrno>
+#include <iostream>
+#include "MonotonicClock.h"
+
+Scheduler::Scheduler(std::chrono::microseconds base_period)
+    : base_period_ns(std::chrono::duration_cast<std::chrono::nanoseconds>(base_period).count()),
+      running(false), ticks(0), deadline_misses(0) {}
+
+int Scheduler::add_stage(const std::string &name, std::chrono::microseconds period, std::function<void()> fn) {
+    if (running) {
+        return -1;
+    }
+
+    // Round the period to the nearest multiple of the base tick (at least one tick)
+    int64_t period_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(period).count();
+    int64_t divider = (period_ns + base_period_ns / 2) / base_period_ns;
+    if (divider < 1) divider = 1;
+    if (divider * base_period_ns != period_ns) {
+        std::cerr << "Scheduler: period of stage '" << name << "' rounded to "
+                  << divider * base_period_ns / 1000 << " us" << std::endl;
+    }
+
+    std::unique_ptr<Stage> stage(new Stage());
+    stage->name = name;
+    stage->divider = static_cast<uint64_t>(divider);
+    stage->fn = fn;
+    stage->runs = 0;
+    stage->overruns = 0;
+    stage->last_runtime_us = 0;
+    stage->max_runtime_us = 0;
+    stages.push_back(std::move(stage));
+    return static_cast<int>(stages.size()) - 1;
+}
+
+void Scheduler::run() {
+    running = true;
+
+    uint64_t tick = 0;
+    int64_t release = monotonic_ns();
+
+    while (running) {
+        // Sleep until the absolute release time of this tick, drift does not accumulate
+        struct timespec release_ts = from_ns(release);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &release_ts, nullptr) == EINTR) {}
+
+        for (auto &stage : stages) {
+            if (tick % stage->divider != 0) continue;
+
+            int64_t start = monotonic_ns();
+            stage->fn();
+            int64_t runtime_us = (monotonic_ns() - start) / 1000;
+
+            stage->runs++;
+            stage->last_runtime_us = runtime_us;
+            if (runtime_us > stage->max_runtime_us) stage->max_runtime_us = runtime_us;
+            if (runtime_us * 1000 > static_cast<int64_t>(stage->divider) * base_period_ns) stage->overruns++;
+        }
+
+        ticks++;
+        tick++;
+        release += base_period_ns;
+
+        // The tick finished after the next release. Run the next tick late, but drop whole
+        // ticks that can no longer be met instead of running them back to back.
+        int64_t end = monotonic_ns();
+        if (end > release) {
+            int64_t skipped = (end - release) / base_period_ns;
+            deadline_misses += 1 + skipped;
+            tick += skipped;
+            release += skipped * base_period_ns;
+        }
+    }
+}
+
+void Scheduler::stop() {
+    running = false;
+}
+
+std::chrono::microseconds Scheduler::get_base_period() const {
+    return std::chrono::microseconds(base_period_ns / 1000);
+}
+
+uint64_t Scheduler::get_deadline_misses() const {
+    return deadline_misses.load();
+}
+
+uint64_t Scheduler::get_ticks() const {
+    return ticks.load();
+}
+
+std::vector<Scheduler::StageStats> Scheduler::get_stage_stats() const {
+    std::vector<StageStats> stats;
+    for (const auto &stage : stages) {
+        StageStats s;
+        s.name = stage->name;
+        s.period_us = static_cast<int64_t>(stage->divider) * base_period_ns / 1000;
+        s.runs = stage->runs.load();
+        s.overruns = stage->overruns.load();
+        s.last_runtime_us = stage->last_runtime_us.load();
+        s.max_runtime_us = stage->max_runtime_us.load();
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+int64_t Scheduler::to_ns(const struct timespec &ts) {
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+struct timespec Scheduler::from_ns(int64_t ns) {
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(ns / 1000000000LL);
+    ts.tv_nsec = static_cast<long>(ns % 1000000000LL);
+    return ts;
+}
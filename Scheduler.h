@@ -0,0 +1,67 @@
+#ifndef DRONE_SCHEDULER_H
+#define DRONE_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <time.h>
+
+// Fixed-rate executor driven by absolute CLOCK_MONOTONIC deadlines.
+// Every stage declares its own period, which is rounded to a multiple of the base tick.
+class Scheduler {
+public:
+    struct StageStats {
+        std::string name;
+        int64_t period_us;
+        uint64_t runs;
+        uint64_t overruns;        // Executions that took longer than the stage period
+        int64_t last_runtime_us;
+        int64_t max_runtime_us;
+    };
+
+    explicit Scheduler(std::chrono::microseconds base_period);
+
+    // Register a stage, stages due in the same tick run in registration order.
+    // Returns the stage id or -1 if the scheduler is already running.
+    int add_stage(const std::string &name, std::chrono::microseconds period, std::function<void()> fn);
+
+    // Run the stages until stop() is called (blocks the calling thread)
+    void run();
+
+    // Request the run loop to return after the current tick
+    void stop();
+
+    std::chrono::microseconds get_base_period() const;
+
+    // Ticks which started after their deadline had already passed
+    uint64_t get_deadline_misses() const;
+    uint64_t get_ticks() const;
+
+    std::vector<StageStats> get_stage_stats() const;
+
+private:
+    struct Stage {
+        std::string name;
+        uint64_t divider;                   // Runs every <divider> ticks
+        std::function<void()> fn;
+        std::atomic<uint64_t> runs;
+        std::atomic<uint64_t> overruns;
+        std::atomic<int64_t> last_runtime_us;
+        std::atomic<int64_t> max_runtime_us;
+    };
+
+    const int64_t base_period_ns;
+    std::vector<std::unique_ptr<Stage>> stages;
+    std::atomic<bool> running;
+    std::atomic<uint64_t> ticks;
+    std::atomic<uint64_t> deadline_misses;
+
+    static int64_t to_ns(const struct timespec &ts);
+    static struct timespec from_ns(int64_t ns);
+};
+
+#endif // DRONE_SCHEDULER_H
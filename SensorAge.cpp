@@ -0,0 +1,46 @@
+#include "SensorAge.h"
+
+constexpr size_t AgeHistogram::BUCKET_COUNT;
+const int64_t AgeHistogram::BUCKET_LIMITS_MS[AgeHistogram::BUCKET_COUNT - 1] = {10, 20, 50, 100, 200, 500, 1000, 2000};
+
+AgeHistogram::AgeHistogram() : stale_count(0), last_age_us(-1), max_age_us(0) {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) counts[i] = 0;
+}
+
+void AgeHistogram::record(int64_t age_us, bool stale) {
+    last_age_us = age_us;
+    if (stale) stale_count++;
+
+    // Missing samples count as infinitely old
+    size_t bucket = BUCKET_COUNT - 1;
+    if (age_us >= 0) {
+        for (size_t i = 0; i < BUCKET_COUNT - 1; ++i) {
+            if (age_us < BUCKET_LIMITS_MS[i] * 1000) {
+                bucket = i;
+                break;
+            }
+        }
+        if (age_us > max_age_us) max_age_us = age_us;
+    }
+    counts[bucket]++;
+}
+
+int64_t AgeHistogram::bucket_limit_ms(size_t bucket) {
+    return bucket < BUCKET_COUNT - 1 ? BUCKET_LIMITS_MS[bucket] : -1;
+}
+
+uint64_t AgeHistogram::get_count(size_t bucket) const {
+    return bucket < BUCKET_COUNT ? counts[bucket].load() : 0;
+}
+
+uint64_t AgeHistogram::get_stale_count() const {
+    return stale_count.load();
+}
+
+int64_t AgeHistogram::get_last_age_us() const {
+    return last_age_us.load();
+}
+
+int64_t AgeHistogram::get_max_age_us() const {
+    return max_age_us.load();
+}
@@ -0,0 +1,36 @@
+#ifndef DRONE_SENSOR_AGE_H
+#define DRONE_SENSOR_AGE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// Histogram of sensor sample ages as seen by the control loop.
+// Recorded by the control thread, read by the telemetry thread without locking.
+class AgeHistogram {
+public:
+    static constexpr size_t BUCKET_COUNT = 9;
+
+    AgeHistogram();
+
+    // Record the age of the sample used in this tick (negative: no sample available)
+    void record(int64_t age_us, bool stale);
+
+    // Upper bound of a bucket in milliseconds, the last bucket is open ended (returns -1)
+    static int64_t bucket_limit_ms(size_t bucket);
+
+    uint64_t get_count(size_t bucket) const;
+    uint64_t get_stale_count() const;       // Samples older than the staleness limit
+    int64_t get_last_age_us() const;        // -1 if no sample was available
+    int64_t get_max_age_us() const;
+
+private:
+    static const int64_t BUCKET_LIMITS_MS[BUCKET_COUNT - 1];
+
+    std::atomic<uint64_t> counts[BUCKET_COUNT];
+    std::atomic<uint64_t> stale_count;
+    std::atomic<int64_t> last_age_us;
+    std::atomic<int64_t> max_age_us;
+};
+
+#endif // DRONE_SENSOR_AGE_H
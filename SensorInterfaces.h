@@ -0,0 +1,59 @@
+#ifndef DRONE_SENSOR_INTERFACES_H
+#define DRONE_SENSOR_INTERFACES_H
+
+#include <cstdint>
+#include "Geodesy.h"
+#include "LatestSample.h"
+
+// Interfaces between the control pipeline and its sensors, RcInterfaces.h has the remote control side.
+// GPS and Compass read the devices of the Raspberry Pi; MemoryBackends.h and SensorReplay.h implement
+// them without hardware, so the pipeline runs in benchmarks, load tests and simulations on any Linux machine.
+
+// Consistent set of GPS values, published as one sample
+struct GpsFix {
+    char time[11];      // hhmmss.sss (UTC)
+    double latitude;    // Decimal degrees
+    double longitude;   // Decimal degrees
+    float altitude_agl; // Meters
+    float speed;        // Speed over ground (knots)
+    float course;       // Course over ground (degrees)
+    int fix_quality;
+    int satellites;
+
+    bool is_reliable() const { return fix_quality > 0 && satellites >= 4; }
+    GeoPosition position() const { return {latitude, longitude, altitude_agl}; }
+};
+
+// Measurement of a heading sensor
+struct CompassSample {
+    float heading;      // Degrees [0, 360)
+    int16_t x, y, z;    // Raw magnetometer values
+};
+
+// Source of position fixes (GPS receiver)
+class PositionSource {
+public:
+    virtual ~PositionSource() {}
+
+    // Open the device and start receiving, false if it is not available
+    virtual bool init() = 0;
+
+    // Publish the data received since the last call, called by the control tick before reading
+    virtual void update() {}
+
+    // Latest fix (lock-free), sequence 0 if there is none yet
+    virtual Sample<GpsFix> get_fix_sample() const = 0;
+};
+
+// Source of the heading (compass)
+class HeadingSource {
+public:
+    virtual ~HeadingSource() {}
+
+    virtual bool init() = 0;
+
+    // Latest measurement (lock-free), sequence 0 if there is none yet
+    virtual Sample<CompassSample> get_sample() const = 0;
+};
+
+#endif // DRONE_SENSOR_INTERFACES_H
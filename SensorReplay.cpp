@@ -0,0 +1,180 @@
+#include "SensorReplay.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+// Longest sleep of the replay thread, bounds the reaction time of stop()
+static const int64_t MAX_SLEEP_NS = 50000000;
+
+SensorReplay::SensorReplay() : next_record(0), start_ns(0), running(false) {}
+
+SensorReplay::~SensorReplay() {
+    stop();
+}
+
+bool SensorReplay::parse_record(const std::string &line, Record &record, std::string &error) {
+    std::istringstream stream(line);
+    double time_ms;
+    std::string type;
+    if (!(stream >> time_ms >> type) || time_ms < 0.0) {
+        error = "expected <ms> <type>";
+        return false;
+    }
+    memset(&record, 0, sizeof(record));
+    record.time_ns = static_cast<int64_t>(time_ms * 1e6);
+
+    if (type == "GPS") {
+        record.type = RecordType::GPS;
+        std::string time;
+        GpsFix &fix = record.fix;
+        if (!(stream >> time >> fix.latitude >> fix.longitude >> fix.altitude_agl >> fix.speed >> fix.course
+                     >> fix.fix_quality >> fix.satellites) || time.size() >= sizeof(fix.time)) {
+            error = "invalid GPS record";
+            return false;
+        }
+        memcpy(fix.time, time.c_str(), time.size() + 1);
+    } else if (type == "COMPASS") {
+        record.type = RecordType::COMPASS;
+        if (!(stream >> record.compass.heading)) {
+            error = "invalid COMPASS record";
+            return false;
+        }
+        int x, y, z;
+        if (stream >> x >> y >> z) {
+            record.compass.x = static_cast<int16_t>(x);
+            record.compass.y = static_cast<int16_t>(y);
+            record.compass.z = static_cast<int16_t>(z);
+        }
+    } else if (type == "RC") {
+        record.type = RecordType::RC;
+        for (int i = 0; i < 16; ++i) {
+            int channel;
+            if (!(stream >> channel) || channel < 0 || channel > 2047) {
+                error = "invalid RC record";
+                return false;
+            }
+            record.packet.channels[i] = static_cast<uint16_t>(channel);
+        }
+        int failsafe, frame_lost;
+        if (stream >> failsafe >> frame_lost) {
+            record.packet.failsafe = failsafe != 0;
+            record.packet.frameLost = frame_lost != 0;
+        }
+    } else {
+        error = "unknown record type " + type;
+        return false;
+    }
+    return true;
+}
+
+bool SensorReplay::load(const std::string &path, std::string &error) {
+    stop();
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    std::vector<Record> loaded;
+    std::string line;
+    for (int line_number = 1; std::getline(file, line); ++line_number) {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+        Record record;
+        if (!parse_record(line, record, error)) {
+            error = path + ":" + std::to_string(line_number) + ": " + error;
+            return false;
+        }
+        if (!loaded.empty() && record.time_ns < loaded.back().time_ns) {
+            error = path + ":" + std::to_string(line_number) + ": records out of order";
+            return false;
+        }
+        loaded.push_back(record);
+    }
+
+    records.swap(loaded);
+    next_record = 0;
+    return true;
+}
+
+size_t SensorReplay::get_record_count() const {
+    return records.size();
+}
+
+int64_t SensorReplay::get_duration_ns() const {
+    return records.empty() ? 0 : records.back().time_ns;
+}
+
+void SensorReplay::rewind(int64_t replay_start_ns) {
+    next_record = 0;
+    start_ns = replay_start_ns;
+}
+
+bool SensorReplay::advance(int64_t now_ns) {
+    while (next_record < records.size() && start_ns + records[next_record].time_ns <= now_ns) {
+        const Record &record = records[next_record++];
+        publish(record, start_ns + record.time_ns);
+    }
+    return next_record < records.size();
+}
+
+void SensorReplay::publish(const Record &record, int64_t timestamp_ns) {
+    switch (record.type) {
+        case RecordType::GPS:
+            position_source.publish(record.fix, timestamp_ns);
+            break;
+        case RecordType::COMPASS:
+            heading_source.publish(record.compass, timestamp_ns);
+            break;
+        case RecordType::RC:
+            rc_input.deliver(record.packet, timestamp_ns);
+            break;
+    }
+}
+
+bool SensorReplay::start(double speed) {
+    if (speed <= 0.0 || running) return false;
+    if (replay_thread.joinable()) replay_thread.join();
+    running = true;
+    replay_thread = std::thread(&SensorReplay::replay, this, speed);
+    return true;
+}
+
+void SensorReplay::stop() {
+    running = false;
+    if (replay_thread.joinable()) replay_thread.join();
+}
+
+bool SensorReplay::is_running() const {
+    return running;
+}
+
+void SensorReplay::replay(double speed) {
+    int64_t replay_start_ns = monotonic_ns();
+    for (size_t index = 0; index < records.size() && running; ++index) {
+        const Record &record = records[index];
+        int64_t due_ns = replay_start_ns + static_cast<int64_t>(record.time_ns / speed);
+        for (int64_t now_ns = monotonic_ns(); now_ns < due_ns && running; now_ns = monotonic_ns()) {
+            int64_t sleep_ns = std::min(due_ns - now_ns, MAX_SLEEP_NS);
+            std::this_thread::sleep_for(std::chrono::nanoseconds(sleep_ns));
+        }
+        if (running) publish(record, monotonic_ns());
+    }
+    running = false;
+}
+
+MemoryPositionSource &SensorReplay::get_position_source() {
+    return position_source;
+}
+
+MemoryHeadingSource &SensorReplay::get_heading_source() {
+    return heading_source;
+}
+
+MemoryRcInput &SensorReplay::get_rc_input() {
+    return rc_input;
+}
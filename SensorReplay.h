@@ -0,0 +1,73 @@
+#ifndef DRONE_SENSOR_REPLAY_H
+#define DRONE_SENSOR_REPLAY_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MemoryBackends.h"
+
+// Replays recorded GPS fixes, compass samples and remote control packets from a text file into
+// memory backends, which stand in for the devices. One record per line, times in milliseconds since
+// the start of the recording and in ascending order, '#' starts a comment:
+//   <ms> GPS <hhmmss.sss> <latitude> <longitude> <altitude> <speed knots> <course> <fix quality> <satellites>
+//   <ms> COMPASS <heading> [<x> <y> <z>]
+//   <ms> RC <channel 1> ... <channel 16> [<failsafe> <frame lost>]
+class SensorReplay {
+public:
+    SensorReplay();
+    ~SensorReplay();
+
+    // Read all records, the error names the offending line
+    bool load(const std::string &path, std::string &error);
+
+    size_t get_record_count() const;
+    int64_t get_duration_ns() const;
+
+    // Stepped replay, e.g. on a simulated clock: the first record is due at <start_ns>
+    void rewind(int64_t start_ns);
+
+    // Publish the records due until <now_ns>, stamped with their recorded time.
+    // Returns false once all records are published.
+    bool advance(int64_t now_ns);
+
+    // Replay in a thread, in real time or <speed> times faster. Records are stamped with the
+    // monotonic_ns() time they are published, so consumers see them as fresh device data.
+    bool start(double speed = 1.0);
+    void stop();
+
+    // False once a started replay has published all records
+    bool is_running() const;
+
+    MemoryPositionSource &get_position_source();
+    MemoryHeadingSource &get_heading_source();
+    MemoryRcInput &get_rc_input();
+
+private:
+    enum class RecordType { GPS, COMPASS, RC };
+    struct Record {
+        int64_t time_ns;        // Since the start of the recording
+        RecordType type;
+        GpsFix fix;
+        CompassSample compass;
+        sbus_packet_t packet;
+    };
+
+    std::vector<Record> records;
+    size_t next_record;
+    int64_t start_ns;
+
+    MemoryPositionSource position_source;
+    MemoryHeadingSource heading_source;
+    MemoryRcInput rc_input;
+
+    std::thread replay_thread;
+    std::atomic<bool> running;
+
+    static bool parse_record(const std::string &line, Record &record, std::string &error);
+    void publish(const Record &record, int64_t timestamp_ns);
+    void replay(double speed);
+};
+
+#endif // DRONE_SENSOR_REPLAY_H
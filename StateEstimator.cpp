@@ -0,0 +1,241 @@
+#include "StateEstimator.h"
+#include <cmath>
+#include <cstring>
+
+static constexpr double KNOTS_TO_MPS = 1852.0 / 3600.0;
+
+constexpr double StateEstimator::GPS_HORIZONTAL_SIGMA;
+constexpr double StateEstimator::GPS_VERTICAL_SIGMA;
+constexpr double StateEstimator::GPS_VELOCITY_SIGMA;
+constexpr double StateEstimator::COMPASS_SIGMA;
+constexpr double StateEstimator::ACCELERATION_NOISE;
+constexpr double StateEstimator::YAW_ACCELERATION_NOISE;
+constexpr double StateEstimator::MAX_STEP;
+
+// Wrap an angle difference to [-180, 180)
+static double wrap_180(double angle) {
+    angle = std::fmod(angle + 180.0, 360.0);
+    if (angle < 0.0) angle += 360.0;
+    return angle - 180.0;
+}
+
+static double wrap_360(double angle) {
+    angle = std::fmod(angle, 360.0);
+    return angle < 0.0 ? angle + 360.0 : angle;
+}
+
+StateEstimator::StateEstimator()
+    : position_valid(false), heading_valid(false), filter_time_ns(0), compass_sequence(0), last_fix({0.0, 0.0, 0.0f}),
+      prediction_count(0), last_prediction_error(0.0f), max_prediction_error(0.0f), prediction_error_square_sum(0.0),
+      hold_error_square_sum(0.0), rms_prediction_error(0.0f), rms_hold_error(0.0f) {
+    gps_epoch[0] = '\0';
+    EstimatedState state = {};
+    published.publish(state, 0);
+}
+
+void StateEstimator::reset() {
+    position_valid = false;
+    heading_valid = false;
+    gps_epoch[0] = '\0';
+    compass_sequence = 0;
+}
+
+void StateEstimator::update(const Sample<GpsFix> &gps_sample, const Sample<CompassSample> &compass_sample, int64_t now_ns) {
+    if (gps_sample.sequence == 0 || !gps_sample.value.is_reliable()) {
+        position_valid = false;
+        gps_epoch[0] = '\0';
+    }
+
+    if (position_valid || heading_valid) {
+        double dt = (now_ns - filter_time_ns) * 1e-9;
+        if (dt < 0.0 || dt > MAX_STEP) {
+            reset();
+        } else if (dt > 0.0) {
+            predict(dt);
+        }
+    }
+    filter_time_ns = now_ns;
+
+    // RMC and GGA of one epoch arrive as separate samples, the position is used once per epoch
+    const GpsFix &fix = gps_sample.value;
+    if (gps_sample.sequence != 0 && fix.is_reliable() && strncmp(gps_epoch, fix.time, sizeof(gps_epoch)) != 0) {
+        memcpy(gps_epoch, fix.time, sizeof(gps_epoch));
+        if (position_valid) {
+            update_gps(fix);
+        } else {
+            start_position(fix);
+        }
+    }
+
+    if (compass_sample.sequence != 0 && compass_sample.sequence != compass_sequence) {
+        compass_sequence = compass_sample.sequence;
+        if (heading_valid) {
+            update_compass(compass_sample.value.heading);
+        } else {
+            start_heading(compass_sample.value.heading);
+        }
+    }
+
+    publish(now_ns);
+}
+
+void StateEstimator::start_position(const GpsFix &fix) {
+    frame.set_origin(fix.position());
+    last_fix = {0.0, 0.0, 0.0f};
+
+    double speed = fix.speed * KNOTS_TO_MPS;
+    double course = fix.course * M_PI / 180.0;
+
+    PositionFilter::State x = PositionFilter::State::zero();
+    x[3] = speed * std::sin(course);
+    x[4] = speed * std::cos(course);
+
+    PositionFilter::Covariance P = PositionFilter::Covariance::zero();
+    P(0, 0) = P(1, 1) = GPS_HORIZONTAL_SIGMA * GPS_HORIZONTAL_SIGMA;
+    P(2, 2) = GPS_VERTICAL_SIGMA * GPS_VERTICAL_SIGMA;
+    P(3, 3) = P(4, 4) = GPS_VELOCITY_SIGMA * GPS_VELOCITY_SIGMA;
+    P(5, 5) = 1.0;
+
+    position_filter.reset(x, P);
+    position_valid = true;
+}
+
+void StateEstimator::start_heading(float heading) {
+    HeadingFilter::State x = HeadingFilter::State::zero();
+    x[0] = wrap_360(heading);
+
+    HeadingFilter::Covariance P = HeadingFilter::Covariance::zero();
+    P(0, 0) = COMPASS_SIGMA * COMPASS_SIGMA;
+    P(1, 1) = 30.0 * 30.0;
+
+    heading_filter.reset(x, P);
+    heading_valid = true;
+}
+
+void StateEstimator::predict(double dt) {
+    // Constant velocity model, white acceleration noise integrated over the step
+    double q11 = dt * dt * dt / 3.0;
+    double q12 = dt * dt / 2.0;
+    double q22 = dt;
+
+    if (position_valid) {
+        Matrix<6, 6> F = Matrix<6, 6>::identity();
+        Matrix<6, 6> Q = Matrix<6, 6>::zero();
+        for (size_t axis = 0; axis < 3; ++axis) {
+            F(axis, axis + 3) = dt;
+            Q(axis, axis) = q11 * ACCELERATION_NOISE;
+            Q(axis, axis + 3) = Q(axis + 3, axis) = q12 * ACCELERATION_NOISE;
+            Q(axis + 3, axis + 3) = q22 * ACCELERATION_NOISE;
+        }
+        position_filter.predict(F, Q);
+    }
+
+    if (heading_valid) {
+        Matrix<2, 2> F = Matrix<2, 2>::identity();
+        F(0, 1) = dt;
+        Matrix<2, 2> Q;
+        Q(0, 0) = q11 * YAW_ACCELERATION_NOISE;
+        Q(0, 1) = Q(1, 0) = q12 * YAW_ACCELERATION_NOISE;
+        Q(1, 1) = q22 * YAW_ACCELERATION_NOISE;
+        heading_filter.predict(F, Q);
+        heading_filter.state()[0] = wrap_360(heading_filter.state()[0]);
+    }
+}
+
+void StateEstimator::update_gps(const GpsFix &fix) {
+    EnuPoint measured = frame.to_enu(fix.position());
+    record_prediction_error(measured);
+    double speed = fix.speed * KNOTS_TO_MPS;
+    double course = fix.course * M_PI / 180.0;
+
+    // Position (east, north, up) and horizontal velocity
+    Matrix<5, 1> z;
+    z[0] = measured.east;
+    z[1] = measured.north;
+    z[2] = measured.up;
+    z[3] = speed * std::sin(course);
+    z[4] = speed * std::cos(course);
+
+    Matrix<5, 6> H = Matrix<5, 6>::zero();
+    H(0, 0) = H(1, 1) = H(2, 2) = H(3, 3) = H(4, 4) = 1.0;
+
+    Matrix<5, 5> R = Matrix<5, 5>::zero();
+    R(0, 0) = R(1, 1) = GPS_HORIZONTAL_SIGMA * GPS_HORIZONTAL_SIGMA;
+    R(2, 2) = GPS_VERTICAL_SIGMA * GPS_VERTICAL_SIGMA;
+    R(3, 3) = R(4, 4) = GPS_VELOCITY_SIGMA * GPS_VELOCITY_SIGMA;
+
+    position_filter.update_measurement(z, H, R);
+}
+
+void StateEstimator::record_prediction_error(const EnuPoint &measured) {
+    // Filter state before the update: the position dead reckoned since the previous fix
+    const PositionFilter::State &x = position_filter.state();
+    float error = static_cast<float>(std::hypot(measured.east - x[0], measured.north - x[1]));
+    float hold_error = static_cast<float>(std::hypot(measured.east - last_fix.east, measured.north - last_fix.north));
+    last_fix = measured;
+
+    uint64_t count = ++prediction_count;
+    prediction_error_square_sum += static_cast<double>(error) * error;
+    hold_error_square_sum += static_cast<double>(hold_error) * hold_error;
+    last_prediction_error = error;
+    if (error > max_prediction_error) max_prediction_error = error;
+    rms_prediction_error = static_cast<float>(std::sqrt(prediction_error_square_sum / count));
+    rms_hold_error = static_cast<float>(std::sqrt(hold_error_square_sum / count));
+}
+
+void StateEstimator::update_compass(float heading) {
+    Matrix<1, 1> innovation;
+    innovation[0] = wrap_180(heading - heading_filter.state()[0]);
+
+    Matrix<1, 2> H = Matrix<1, 2>::zero();
+    H(0, 0) = 1.0;
+    Matrix<1, 1> R;
+    R(0, 0) = COMPASS_SIGMA * COMPASS_SIGMA;
+
+    heading_filter.update(innovation, H, R);
+    heading_filter.state()[0] = wrap_360(heading_filter.state()[0]);
+}
+
+void StateEstimator::publish(int64_t now_ns) {
+    EstimatedState state = {};
+    state.valid = position_valid && heading_valid;
+    if (position_valid) {
+        const PositionFilter::State &x = position_filter.state();
+        const PositionFilter::Covariance &P = position_filter.covariance();
+        state.position = get_position();
+        state.velocity_east = static_cast<float>(x[3]);
+        state.velocity_north = static_cast<float>(x[4]);
+        state.climb_rate = static_cast<float>(x[5]);
+        state.position_sigma = static_cast<float>(std::sqrt(P(0, 0) + P(1, 1)));
+    }
+    if (heading_valid) {
+        state.heading = static_cast<float>(heading_filter.state()[0]);
+        state.yaw_rate = static_cast<float>(heading_filter.state()[1]);
+        state.heading_sigma = static_cast<float>(std::sqrt(heading_filter.covariance()(0, 0)));
+    }
+    published.publish(state, now_ns);
+}
+
+bool StateEstimator::is_valid() const {
+    return position_valid && heading_valid;
+}
+
+GeoPosition StateEstimator::get_position() const {
+    const PositionFilter::State &x = position_filter.state();
+    EnuPoint point = {x[0], x[1], static_cast<float>(x[2])};
+    return frame.to_geodetic(point);
+}
+
+float StateEstimator::get_heading() const {
+    return static_cast<float>(heading_filter.state()[0]);
+}
+
+EstimatedState StateEstimator::get_state() const {
+    return published.value();
+}
+
+uint64_t StateEstimator::get_prediction_count() const { return prediction_count.load(); }
+float StateEstimator::get_last_prediction_error() const { return last_prediction_error.load(); }
+float StateEstimator::get_max_prediction_error() const { return max_prediction_error.load(); }
+float StateEstimator::get_rms_prediction_error() const { return rms_prediction_error.load(); }
+float StateEstimator::get_rms_hold_error() const { return rms_hold_error.load(); }
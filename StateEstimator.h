@@ -0,0 +1,104 @@
+#ifndef DRONE_STATE_ESTIMATOR_H
+#define DRONE_STATE_ESTIMATOR_H
+
+#include <atomic>
+#include <cstdint>
+#include "SensorInterfaces.h"
+#include "Geodesy.h"
+#include "KalmanFilter.h"
+#include "LatestSample.h"
+
+// Smoothed vehicle state as published by the StateEstimator
+struct EstimatedState {
+    bool valid;             // False until the first reliable GPS fix
+    GeoPosition position;
+    float velocity_east;    // m/s
+    float velocity_north;   // m/s
+    float climb_rate;       // m/s
+    float heading;          // Degrees [0, 360)
+    float yaw_rate;         // Degrees/s
+    float position_sigma;   // Horizontal 1-sigma uncertainty (meters)
+    float heading_sigma;    // Degrees
+};
+
+// Loosely coupled GPS/compass estimator. Two independent constant-velocity Kalman filters:
+//  - position: [east, north, up, v_east, v_north, v_up] in a local frame anchored at the first fix,
+//    updated with the GPS position and the horizontal velocity from speed/course over ground
+//  - heading: [heading, yaw rate], updated with the compass heading
+// Between GPS fixes the position is dead reckoned with the estimated velocity. When a new fix
+// arrives, the distance between the predicted and the measured position is recorded, next to the
+// distance the position would have been off by simply holding the previous fix.
+// Runs in the control thread at the control rate, the state and metrics may be read from any thread.
+class StateEstimator {
+public:
+    StateEstimator();
+
+    // Advance the filters to <now_ns> and apply new GPS epochs and compass samples
+    void update(const Sample<GpsFix> &gps_sample, const Sample<CompassSample> &compass_sample, int64_t now_ns);
+
+    // Drop the state, the next reliable fix starts the filters again
+    void reset();
+
+    bool is_valid() const;
+    GeoPosition get_position() const;
+    float get_heading() const;
+
+    // Consistent snapshot of the state for other threads
+    EstimatedState get_state() const;
+
+    // Horizontal prediction error at each GPS fix (meters)
+    uint64_t get_prediction_count() const;
+    float get_last_prediction_error() const;
+    float get_max_prediction_error() const;
+    float get_rms_prediction_error() const;
+    float get_rms_hold_error() const;   // Same for holding the previous fix, for comparison
+
+    // Measurement noise (1-sigma)
+    static constexpr double GPS_HORIZONTAL_SIGMA = 2.5;     // Meters
+    static constexpr double GPS_VERTICAL_SIGMA = 5.0;       // Meters
+    static constexpr double GPS_VELOCITY_SIGMA = 0.3;       // m/s
+    static constexpr double COMPASS_SIGMA = 3.0;            // Degrees
+
+    // Process noise: white acceleration spectral densities
+    static constexpr double ACCELERATION_NOISE = 2.0;       // (m/s^2)^2 / Hz
+    static constexpr double YAW_ACCELERATION_NOISE = 400.0; // (deg/s^2)^2 / Hz
+
+    // Larger steps (e.g. after a stall) restart the filters instead of extrapolating
+    static constexpr double MAX_STEP = 1.0;                 // Seconds
+
+private:
+    typedef KalmanFilter<6> PositionFilter;
+    typedef KalmanFilter<2> HeadingFilter;
+
+    bool position_valid;
+    bool heading_valid;
+    int64_t filter_time_ns;
+    LocalFrame frame;
+
+    PositionFilter position_filter;
+    HeadingFilter heading_filter;
+
+    char gps_epoch[11];
+    uint64_t compass_sequence;
+    EnuPoint last_fix;      // Measured position of the previous GPS epoch
+
+    std::atomic<uint64_t> prediction_count;
+    std::atomic<float> last_prediction_error;
+    std::atomic<float> max_prediction_error;
+    double prediction_error_square_sum;
+    double hold_error_square_sum;
+    std::atomic<float> rms_prediction_error;
+    std::atomic<float> rms_hold_error;
+
+    LatestSample<EstimatedState> published;
+
+    void start_position(const GpsFix &fix);
+    void start_heading(float heading);
+    void predict(double dt);
+    void update_gps(const GpsFix &fix);
+    void record_prediction_error(const EnuPoint &measured);
+    void update_compass(float heading);
+    void publish(int64_t now_ns);
+};
+
+#endif // DRONE_STATE_ESTIMATOR_H
@@ -0,0 +1,159 @@
+#include "TelemetryPublisher.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/ip.h>
+#include <time.h>
+#include <nlohmann/json.hpp>
+#include "MonotonicClock.h"
+
+using json = nlohmann::json;
+
+constexpr double TelemetryPublisher::DEFAULT_RATE_HZ;
+constexpr size_t TelemetryPublisher::MAX_ENDPOINTS;
+
+TelemetryPublisher::TelemetryPublisher(ControlLoop &control_loop, double rate_hz)
+    : control_loop(control_loop), period_ns(static_cast<int64_t>(1e9 / rate_hz)), socket_fd(-1), running(false),
+      next_endpoint_id(1), sequence(0), send_errors(0) {}
+
+TelemetryPublisher::~TelemetryPublisher() {
+    stop();
+}
+
+bool TelemetryPublisher::start() {
+    if (running) return false;
+
+    socket_fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (socket_fd < 0) {
+        perror("UDP socket failed");
+        return false;
+    }
+
+    // Ask routers to prefer latency, and let multicast datagrams cross a few hops (VPN)
+    int tos = IPTOS_LOWDELAY;
+    setsockopt(socket_fd, IPPROTO_IP, IP_TOS, &tos, sizeof(tos));
+    unsigned char ttl = 4;
+    setsockopt(socket_fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+
+    running = true;
+    thread = std::thread(&TelemetryPublisher::run, this);
+    return true;
+}
+
+void TelemetryPublisher::stop() {
+    if (!running) return;
+    running = false;
+    if (thread.joinable()) thread.join();
+    close(socket_fd);
+    socket_fd = -1;
+}
+
+int TelemetryPublisher::add_endpoint(const sockaddr_in &address, MessageEncoding encoding) {
+    std::lock_guard<std::mutex> lock(endpoint_mutex);
+    if (endpoints.size() >= MAX_ENDPOINTS) return -1;
+    Endpoint endpoint = {next_endpoint_id++, address, encoding};
+    endpoints.push_back(endpoint);
+    return endpoint.id;
+}
+
+void TelemetryPublisher::remove_endpoint(int id) {
+    std::lock_guard<std::mutex> lock(endpoint_mutex);
+    for (auto it = endpoints.begin(); it != endpoints.end(); ++it) {
+        if (it->id == id) {
+            endpoints.erase(it);
+            return;
+        }
+    }
+}
+
+double TelemetryPublisher::get_rate() const {
+    return 1e9 / period_ns;
+}
+
+uint64_t TelemetryPublisher::get_sequence() const {
+    return sequence;
+}
+
+uint64_t TelemetryPublisher::get_send_errors() const {
+    return send_errors;
+}
+
+size_t TelemetryPublisher::get_endpoint_count() const {
+    std::lock_guard<std::mutex> lock(endpoint_mutex);
+    return endpoints.size();
+}
+
+void TelemetryPublisher::run() {
+    int64_t release = monotonic_ns();
+    while (running) {
+        // Absolute deadlines, so the rate does not drift with the publishing time
+        release += period_ns;
+        struct timespec release_ts = {static_cast<time_t>(release / 1000000000LL), static_cast<long>(release % 1000000000LL)};
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &release_ts, nullptr) == EINTR) {}
+
+        // Skip the ticks missed while the thread was not scheduled
+        int64_t now = monotonic_ns();
+        if (now - release > period_ns) release = now;
+
+        publish(sequence + 1);
+    }
+}
+
+void TelemetryPublisher::publish(uint64_t seq) {
+    std::vector<Endpoint> targets;
+    {
+        std::lock_guard<std::mutex> lock(endpoint_mutex);
+        targets = endpoints;
+    }
+    // Sequence numbers count snapshots, not datagrams: they also advance without receivers
+    sequence = seq;
+    if (targets.empty()) return;
+
+    // Encoded once per encoding in use
+    json snapshot = build_snapshot(seq);
+    std::string encoded[3];
+    for (const Endpoint &endpoint : targets) {
+        std::string &datagram = encoded[static_cast<int>(endpoint.encoding)];
+        if (datagram.empty()) datagram = encodeMessage(endpoint.encoding, snapshot);
+
+        ssize_t sent = sendto(socket_fd, datagram.data(), datagram.size(), 0,
+                              reinterpret_cast<const sockaddr *>(&endpoint.address), sizeof(endpoint.address));
+        if (sent < 0) send_errors++;
+    }
+}
+
+json TelemetryPublisher::build_snapshot(uint64_t seq) const {
+    Sample<GpsFix> gps_sample = control_loop.get_position_source().get_fix_sample();
+    EstimatedState state = control_loop.get_state_estimator().get_state();
+    int64_t unix_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    return {
+        {"type", "STATE"},
+        {"seq", seq},
+        {"time_ns", monotonic_ns()},      // Monotonic, for intervals
+        {"unix_ms", unix_ms},       // Wall clock, for the latency with a synchronized ground station
+        {"control_loop_state", static_cast<int>(control_loop.get_position_control_state())},
+        {"position",
+            {
+                {"lat", state.position.latitude},
+                {"lon", state.position.longitude},
+                {"altitude", state.position.altitude},
+                {"sigma", state.position_sigma}
+            }
+        },
+        {"velocity", {state.velocity_east, state.velocity_north, state.climb_rate}},
+        {"heading", state.heading},
+        {"estimate_valid", state.valid},
+        {"gps",
+            {
+                {"fix_quality", gps_sample.value.fix_quality},
+                {"satellites", gps_sample.value.satellites},
+                {"age_ms", gps_sample.sequence > 0 ? (monotonic_ns() - gps_sample.timestamp_ns) / 1000000 : -1}
+            }
+        }
+    };
+}
@@ -0,0 +1,62 @@
+#ifndef DRONE_TELEMETRY_PUBLISHER_H
+#define DRONE_TELEMETRY_PUBLISHER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+#include <nlohmann/json_fwd.hpp>
+#include "ControlLoop.h"
+#include "MessageEncoding.h"
+
+// Sends state snapshots over UDP at a fixed rate to registered endpoints (unicast or multicast).
+// Lost datagrams are simply superseded by the next one, so a ground station always shows the
+// freshest state and can measure loss from the sequence numbers. Commands stay on TCP.
+class TelemetryPublisher {
+public:
+    static constexpr double DEFAULT_RATE_HZ = 10.0;
+    static constexpr size_t MAX_ENDPOINTS = 16;
+
+    explicit TelemetryPublisher(ControlLoop &control_loop, double rate_hz = DEFAULT_RATE_HZ);
+    ~TelemetryPublisher();
+
+    bool start();
+    void stop();
+
+    // Register an endpoint, returns its id or -1 if the endpoint limit is reached
+    int add_endpoint(const sockaddr_in &address, MessageEncoding encoding);
+    void remove_endpoint(int id);
+
+    double get_rate() const;
+    uint64_t get_sequence() const;      // Snapshots published so far
+    uint64_t get_send_errors() const;   // Datagrams that could not be sent
+    size_t get_endpoint_count() const;
+
+private:
+    struct Endpoint {
+        int id;
+        sockaddr_in address;
+        MessageEncoding encoding;
+    };
+
+    ControlLoop &control_loop;
+    const int64_t period_ns;
+    int socket_fd;
+    std::thread thread;
+    std::atomic<bool> running;
+
+    mutable std::mutex endpoint_mutex;
+    std::vector<Endpoint> endpoints;
+    int next_endpoint_id;
+
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> send_errors;
+
+    void run();
+    void publish(uint64_t seq);
+    nlohmann::json build_snapshot(uint64_t seq) const;
+};
+
+#endif // DRONE_TELEMETRY_PUBLISHER_H
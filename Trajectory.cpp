@@ -0,0 +1,70 @@
+#include "Trajectory.h"
+#include <cmath>
+
+static float normalize_heading(float heading) {
+    heading = std::fmod(heading, 360.0f);
+    return heading < 0.0f ? heading + 360.0f : heading;
+}
+
+Trajectory::Trajectory()
+    : origin({0.0, 0.0, 0.0f}), direction_east(0.0), direction_north(0.0), altitude_sign(1.0f),
+      heading_start(0.0f), heading_sign(1.0f) {}
+
+Trajectory Trajectory::compile(const EnuPoint &start, const EnuPoint &end, float start_heading, float end_heading,
+                               float speed, float altitude_speed, float yaw_speed, const TrajectoryLimits &limits) {
+    Trajectory trajectory;
+    trajectory.origin = start;
+
+    double east = end.east - start.east;
+    double north = end.north - start.north;
+    double length = std::sqrt(east * east + north * north);
+    trajectory.direction_east = length > 0.0 ? east / length : 0.0;
+    trajectory.direction_north = length > 0.0 ? north / length : 0.0;
+    trajectory.horizontal = MotionProfile(length, std::fabs(speed) * 1000.0 / 3600.0, limits.horizontal);
+
+    float altitude_change = end.up - start.up;
+    trajectory.altitude_sign = altitude_change < 0.0f ? -1.0f : 1.0f;
+    trajectory.vertical = MotionProfile(std::fabs(altitude_change), std::fabs(altitude_speed) * 1000.0 / 3600.0,
+                                        limits.vertical);
+
+    // Turn the shorter way, the only place the angles need normalizing
+    trajectory.heading_start = normalize_heading(start_heading);
+    float clockwise = normalize_heading(end_heading - start_heading);
+    float sweep = clockwise <= 180.0f ? clockwise : clockwise - 360.0f;
+    trajectory.heading_sign = sweep < 0.0f ? -1.0f : 1.0f;
+    trajectory.yaw = MotionProfile(std::fabs(sweep), std::fabs(yaw_speed), limits.yaw);
+    return trajectory;
+}
+
+void Trajectory::evaluate(float t, TrajectorySample &sample) const {
+    double distance, altitude, rotation, velocity;
+
+    horizontal.evaluate(t, distance, velocity);
+    sample.position.east = origin.east + direction_east * distance;
+    sample.position.north = origin.north + direction_north * distance;
+    sample.velocity_east = static_cast<float>(direction_east * velocity);
+    sample.velocity_north = static_cast<float>(direction_north * velocity);
+
+    vertical.evaluate(t, altitude, velocity);
+    sample.position.up = origin.up + altitude_sign * static_cast<float>(altitude);
+    sample.climb_rate = altitude_sign * static_cast<float>(velocity);
+
+    // heading_start is in [0, 360) and the sweep within +-180, so one correction normalizes the result
+    yaw.evaluate(t, rotation, velocity);
+    float heading = heading_start + heading_sign * static_cast<float>(rotation);
+    if (heading >= 360.0f) heading -= 360.0f;
+    else if (heading < 0.0f) heading += 360.0f;
+    sample.heading = heading;
+    sample.yaw_rate = heading_sign * static_cast<float>(velocity);
+}
+
+double Trajectory::get_length() const {
+    return horizontal.get_distance();
+}
+
+float Trajectory::get_duration() const {
+    double duration = horizontal.get_duration();
+    if (vertical.get_duration() > duration) duration = vertical.get_duration();
+    if (yaw.get_duration() > duration) duration = yaw.get_duration();
+    return static_cast<float>(duration);
+}
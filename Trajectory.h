@@ -0,0 +1,57 @@
+#ifndef DRONE_TRAJECTORY_H
+#define DRONE_TRAJECTORY_H
+
+#include "Geodesy.h"
+#include "MotionProfile.h"
+
+// Motion limits of the temporary target per axis
+struct TrajectoryLimits {
+    MotionLimits horizontal;    // m/s^2, m/s^3 along the leg
+    MotionLimits vertical;      // m/s^2, m/s^3
+    MotionLimits yaw;           // Degrees/s^2, degrees/s^3
+};
+
+// Temporary target at one point in time
+struct TrajectorySample {
+    EnuPoint position;
+    float heading;          // Degrees [0, 360)
+    float velocity_east;    // m/s
+    float velocity_north;   // m/s
+    float climb_rate;       // m/s
+    float yaw_rate;         // Degrees/s, positive clockwise
+};
+
+// Straight leg compiled into a parametric form when it is planned: origin, unit direction, length,
+// altitude change and signed heading sweep, each axis moved along its own jerk limited motion
+// profile. Evaluating it per control tick is a handful of multiplies and comparisons, without
+// trigonometry or fmod.
+class Trajectory {
+public:
+    Trajectory();
+
+    // Leg from <start> to <end>, turning the shorter way (clockwise on a tie) from <start_heading> to
+    // <end_heading>. Speeds as in the target commands: km/h horizontally and vertically, degrees/s for yaw.
+    static Trajectory compile(const EnuPoint &start, const EnuPoint &end, float start_heading, float end_heading,
+                              float speed, float altitude_speed, float yaw_speed, const TrajectoryLimits &limits);
+
+    // Temporary target <t> seconds after the start of the leg
+    void evaluate(float t, TrajectorySample &sample) const;
+
+    double get_length() const;      // Horizontal length (meters)
+    float get_duration() const;     // Seconds until all axes reached the end, infinite if a speed is zero
+
+private:
+    EnuPoint origin;
+    double direction_east;      // Unit vector along the leg
+    double direction_north;
+    MotionProfile horizontal;   // Meters along the leg
+
+    float altitude_sign;        // +1 climbing, -1 sinking
+    MotionProfile vertical;     // Meters of altitude change
+
+    float heading_start;        // Degrees [0, 360)
+    float heading_sign;         // +1 clockwise, -1 counter-clockwise
+    MotionProfile yaw;          // Degrees of the sweep, at most 180
+};
+
+#endif // DRONE_TRAJECTORY_H
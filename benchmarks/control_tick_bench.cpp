@@ -0,0 +1,166 @@
+// Cost of one full control tick (sensor snapshot, estimator, trajectory, PID) on memory backends,
+// alone, with the flight recorder and while other threads poll the control state like the Connector
+// and the SBUS writer do.
+// Sensor data is synthetic or replayed from a SensorReplay file; the tick runs on a simulated clock.
+// Usage: control_tick_bench [ticks] [reader threads] [replay file]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ControlLoop.h"
+#include "FlightRecorder.h"
+#include "MemoryBackends.h"
+#include "SensorReplay.h"
+
+static const int64_t CONTROL_PERIOD_NS = 14000000;
+static const int GPS_EVERY_TICKS = 14;              // ~5 Hz
+static const int64_t START_NS = 1000000000;
+static const GeoPosition ORIGIN = {51.9607, 7.6261, 20.0f};
+
+struct Timing {
+    std::vector<double> samples_ns;
+
+    void print(const char *name) {
+        std::sort(samples_ns.begin(), samples_ns.end());
+        double total = 0;
+        for (double ns : samples_ns) total += ns;
+        size_t count = samples_ns.size();
+        printf("%-15s %8.0f ns/tick mean, p99 %.0f ns, max %.0f ns (%zu ticks)\n", name, total / count,
+               samples_ns[count * 99 / 100], samples_ns.back(), count);
+    }
+};
+
+// Circle flight of 30 m radius at 5 m/s, published like the receivers would
+class SyntheticFlight {
+public:
+    SyntheticFlight() : frame(ORIGIN) {}
+
+    void publish(int tick, int64_t now_ns, MemoryPositionSource &position, MemoryHeadingSource &heading) {
+        double t = (now_ns - START_NS) * 1e-9;
+        double angle = t * 5.0 / 30.0;
+        double course = std::fmod(angle * 180.0 / M_PI + 90.0, 360.0);
+        if (tick % GPS_EVERY_TICKS == 0) {
+            GpsFix fix;
+            memset(&fix, 0, sizeof(fix));
+            GeoPosition geo = frame.to_geodetic({30.0 * std::sin(angle), 30.0 * std::cos(angle), 20.0f});
+            fix.latitude = geo.latitude;
+            fix.longitude = geo.longitude;
+            fix.altitude_agl = geo.altitude;
+            fix.speed = static_cast<float>(5.0 * 3600.0 / 1852.0);
+            fix.course = static_cast<float>(course);
+            fix.fix_quality = 1;
+            fix.satellites = 10;
+            snprintf(fix.time, sizeof(fix.time), "%09.2f", t);
+            position.publish(fix, now_ns);
+        }
+        CompassSample sample = {static_cast<float>(course), 0, 0, 0};
+        heading.publish(sample, now_ns);
+    }
+
+private:
+    LocalFrame frame;
+};
+
+int main(int argc, char **argv) {
+    const int ticks = argc > 1 ? atoi(argv[1]) : 100000;
+    const int readers = argc > 2 ? atoi(argv[2]) : 2;
+    const char *replay_file = argc > 3 ? argv[3] : nullptr;
+
+    MemoryPositionSource position;
+    MemoryHeadingSource heading;
+    SyntheticFlight flight;
+    SensorReplay replay;
+    if (replay_file != nullptr) {
+        std::string error;
+        if (!replay.load(replay_file, error)) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        printf("replaying %zu records (%.1f s)\n", replay.get_record_count(), replay.get_duration_ns() * 1e-9);
+    }
+    PositionSource &position_source = replay_file != nullptr ? static_cast<PositionSource &>(replay.get_position_source()) : position;
+    HeadingSource &heading_source = replay_file != nullptr ? static_cast<HeadingSource &>(replay.get_heading_source()) : heading;
+
+    ControlLoop control_loop(position_source, heading_source);
+    std::streambuf *cout_buffer = std::cout.rdbuf(nullptr);     // State changes are printed
+    std::streambuf *cerr_buffer = std::cerr.rdbuf(nullptr);
+
+    int tick = 0;
+    int64_t now_ns = START_NS;
+    replay.rewind(now_ns);
+    auto step = [&]() -> double {
+        now_ns += CONTROL_PERIOD_NS;
+        if (replay_file != nullptr) {
+            if (!replay.advance(now_ns)) replay.rewind(now_ns);
+        } else {
+            flight.publish(tick, now_ns, position, heading);
+        }
+        tick++;
+
+        auto start = std::chrono::steady_clock::now();
+        control_loop.update_signals(position_source.get_fix_sample(), heading_source.get_sample(), now_ns);
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // Steer towards a target far away, so every tick runs the whole pipeline
+    for (int i = 0; i < 2 * GPS_EVERY_TICKS; ++i) step();
+    GeoPosition target = geo_offset(position_source.get_fix_sample().value.position(), 0.0, 1000.0);
+    control_loop.set_target(target.latitude, target.longitude, target.altitude, 0.0f, 20.0f, 5.0f, 30.0f);
+    for (int i = 0; i < 10; ++i) step();
+    bool active = control_loop.get_position_control_state() == ControlLoop::PositionControlState::ACTIVE;
+
+    Timing alone;
+    for (int i = 0; i < ticks; ++i) alone.samples_ns.push_back(step());
+
+    const char *log_file = "/tmp/control_tick_bench.log";
+    FlightRecorder recorder;
+    std::string recorder_error;
+    Timing recorded;
+    if (recorder.open(log_file, FlightRecorder::DEFAULT_CAPACITY, recorder_error)) {
+        control_loop.set_flight_recorder(&recorder);
+        for (int i = 0; i < ticks; ++i) recorded.samples_ns.push_back(step());
+        control_loop.set_flight_recorder(nullptr);
+        recorder.close();
+        remove(log_file);
+    }
+
+    // Readers as in the running controller: state requests of clients and the SBUS write stage
+    std::atomic<bool> reading(true);
+    std::atomic<uint64_t> reads(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < readers; ++i) {
+        threads.emplace_back([&control_loop, &reading, &reads, i] {
+            while (reading) {
+                if (i % 2 == 0) control_loop.get_json_state();
+                else control_loop.get_steering_signals();
+                reads++;
+            }
+        });
+    }
+    Timing contended;
+    auto contended_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ticks; ++i) contended.samples_ns.push_back(step());
+    double contended_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - contended_start).count();
+    reading = false;
+    for (std::thread &thread : threads) thread.join();
+
+    std::cout.rdbuf(cout_buffer);
+    std::cerr.rdbuf(cerr_buffer);
+    printf("target %s\n", active ? "active" : "NOT active, ticks stop early");
+    alone.print("tick");
+    if (recorded.samples_ns.empty()) printf("tick recorded   failed: %s\n", recorder_error.c_str());
+    else recorded.print("tick recorded");
+    char name[32];
+    snprintf(name, sizeof(name), "tick %d readers", readers);
+    contended.print(name);
+    printf("reader calls:   %.0f per second\n", reads / contended_s);
+    printf("budget:         %8lld ns/tick\n", static_cast<long long>(CONTROL_PERIOD_NS));
+    return 0;
+}
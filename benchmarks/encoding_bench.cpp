@@ -0,0 +1,97 @@
+// Size and encode/decode cost of a telemetry message in the encodings the Connector offers
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <nlohmann/json.hpp>
+#include "MessageEncoding.h"
+
+using json = nlohmann::json;
+
+// Same layout as Connector::getTelemetry()
+static json sampleTelemetry() {
+    json histogram = {
+        {"limits_ms", {10, 20, 50, 100, 200, 500, 1000, 2000, -1}},
+        {"counts", {1520, 233, 80, 12, 3, 0, 0, 0, 0}},
+        {"stale", 0},
+        {"last_age_us", 8423},
+        {"max_age_us", 184211}
+    };
+    return {
+        {"type", "TELEMETRY"},
+        {"gps",
+            {
+                {"lat", 51.96071234},
+                {"lon", 7.62612345},
+                {"altitude", 12.5f},
+                {"speed", 3.2f},
+                {"time", "123519.00"},
+                {"fix_quality", 1},
+                {"satellites", 9},
+                {"reliable", true}
+            }
+        },
+        {"compass", {{"heading", 271.3f}}},
+        {"estimate",
+            {
+                {"valid", true},
+                {"latitude", 51.96071301},
+                {"longitude", 7.62612399},
+                {"altitude", 12.2f},
+                {"velocity_east", -1.2f},
+                {"velocity_north", 2.9f},
+                {"climb_rate", 0.1f},
+                {"heading", 271.1f},
+                {"yaw_rate", 0.4f},
+                {"position_sigma", 0.8f},
+                {"heading_sigma", 1.1f}
+            }
+        },
+        {"gps_prediction",
+            {
+                {"fixes", 1234},
+                {"last_error", 0.4f},
+                {"max_error", 2.1f},
+                {"rms_error", 0.6f},
+                {"rms_hold_error", 1.4f}
+            }
+        },
+        {"sensor_age", {{"gps", histogram}, {"compass", histogram}}}
+    };
+}
+
+int main(int argc, char **argv) {
+    const int iterations = argc > 1 ? atoi(argv[1]) : 20000;
+    const json message = sampleTelemetry();
+    const MessageEncoding encodings[] = {MessageEncoding::JSON, MessageEncoding::CBOR, MessageEncoding::MSGPACK};
+
+    typedef std::chrono::steady_clock clock;
+    double json_encode_ns = 0;
+    size_t json_size = 0;
+
+    printf("%-8s %8s %12s %12s\n", "encoding", "bytes", "encode ns", "decode ns");
+    for (MessageEncoding encoding : encodings) {
+        size_t size = 0;
+        auto start = clock::now();
+        for (int n = 0; n < iterations; ++n) size += encodeMessage(encoding, message).size();
+        double encode_ns = std::chrono::duration<double, std::nano>(clock::now() - start).count() / iterations;
+        size /= iterations;
+
+        std::string encoded = encodeMessage(encoding, message);
+        size_t checksum = 0;
+        start = clock::now();
+        for (int n = 0; n < iterations; ++n) checksum += decodeMessage(encoding, encoded).size();
+        double decode_ns = std::chrono::duration<double, std::nano>(clock::now() - start).count() / iterations;
+
+        if (decodeMessage(encoding, encoded) != message || checksum == 0) {
+            printf("%s: round trip mismatch\n", encodingName(encoding));
+            return 1;
+        }
+        if (encoding == MessageEncoding::JSON) {
+            json_encode_ns = encode_ns;
+            json_size = size;
+        }
+        printf("%-8s %8zu %12.0f %12.0f   (%.0f%% of the JSON size, %.2fx JSON encode time)\n", encodingName(encoding),
+               size, encode_ns, decode_ns, 100.0 * size / json_size, encode_ns / json_encode_ns);
+    }
+    return 0;
+}
@@ -0,0 +1,45 @@
+// Precision of the local ENU frame used by ControlLoop versus the spherical distance/bearing math,
+// over typical mission distances. The frame origin is the start of the leg, like in set_target().
+#include <cmath>
+#include <cstdio>
+#include "Geodesy.h"
+
+int main() {
+    const GeoPosition origin = {51.9607, 7.6261, 0.0f};
+    const LocalFrame frame(origin);
+    const double ranges[] = {10.0, 50.0, 100.0, 250.0, 500.0, 1000.0, 1500.0, 2000.0};
+
+    printf("%10s %18s %18s %22s\n", "range (m)", "max distance err", "max bearing err", "max carrot round trip");
+    for (double range : ranges) {
+        double max_distance_error = 0.0;
+        double max_bearing_error = 0.0;
+        double max_round_trip_error = 0.0;
+
+        for (int step = 0; step < 360; ++step) {
+            double bearing = step;
+            GeoPosition target = geo_offset(origin, bearing, range);
+
+            // Spherical reference
+            double reference_distance = geo_distance(origin, target);
+            double reference_bearing = geo_bearing(origin, target);
+
+            // Local frame
+            EnuPoint point = frame.to_enu(target);
+            double distance = std::sqrt(point.east * point.east + point.north * point.north);
+            double enu_bearing = std::fmod(std::atan2(point.east, point.north) * 180.0 / M_PI + 360.0, 360.0);
+
+            double bearing_error = std::fabs(enu_bearing - reference_bearing);
+            if (bearing_error > 180.0) bearing_error = 360.0 - bearing_error;
+
+            // Carrot generated in the frame and sent back to geodetic (temp target in the JSON state)
+            GeoPosition round_trip = frame.to_geodetic(point);
+
+            max_distance_error = std::fmax(max_distance_error, std::fabs(distance - reference_distance));
+            max_bearing_error = std::fmax(max_bearing_error, bearing_error);
+            max_round_trip_error = std::fmax(max_round_trip_error, geo_distance(round_trip, target));
+        }
+
+        printf("%10.0f %16.4f m %16.5f ° %20.6f m\n", range, max_distance_error, max_bearing_error, max_round_trip_error);
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+// Cost of one StateEstimator step at the control rate, split into predict-only ticks and ticks
+// that also apply a GPS epoch, plus the noise reduction on a simulated flight
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "StateEstimator.h"
+
+static const int64_t CONTROL_PERIOD_NS = 14000000;  // Same as main.cpp
+static const int GPS_EVERY_TICKS = 14;              // ~5 Hz
+static const double GPS_NOISE = 2.5;                // Meters
+static const double COMPASS_NOISE = 3.0;            // Degrees
+
+struct Timing {
+    std::vector<double> samples_ns;
+
+    void print(const char *name) {
+        std::sort(samples_ns.begin(), samples_ns.end());
+        double total = 0;
+        for (double ns : samples_ns) total += ns;
+        size_t count = samples_ns.size();
+        printf("%-15s %8.0f ns/step mean, p99 %.0f ns, max %.0f ns (%zu steps)\n", name, total / count,
+               samples_ns[count * 99 / 100], samples_ns.back(), count);
+    }
+};
+
+int main(int argc, char **argv) {
+    const int ticks = argc > 1 ? atoi(argv[1]) : 200000;
+
+    std::mt19937 rng(42);
+    std::normal_distribution<double> gps_noise(0.0, GPS_NOISE);
+    std::normal_distribution<double> compass_noise(0.0, COMPASS_NOISE);
+
+    const GeoPosition origin = {51.9607, 7.6261, 10.0f};
+    LocalFrame frame(origin);
+
+    StateEstimator estimator;
+    Sample<GpsFix> gps_sample = {};
+    Sample<CompassSample> compass_sample = {};
+
+    Timing predict_timing;
+    Timing gps_timing;
+    double raw_square_sum = 0, filtered_square_sum = 0;
+    double raw_heading_square_sum = 0, filtered_heading_square_sum = 0;
+    long error_samples = 0;
+    EnuPoint last_gps = {0, 0, 0};
+
+    typedef std::chrono::steady_clock clock;
+    for (int tick = 0; tick < ticks; ++tick) {
+        int64_t now_ns = (tick + 1) * CONTROL_PERIOD_NS;
+        double t = now_ns * 1e-9;
+
+        // Slow circle with 50 m radius at 3 m/s, nose pointing along the track
+        const double radius = 50.0, speed = 3.0;
+        double angle = speed / radius * t;
+        EnuPoint truth = {radius * std::sin(angle), radius * (1.0 - std::cos(angle)), 0.0f};
+        double course = std::fmod(90.0 - std::fmod(angle * 180.0 / M_PI, 360.0) + 360.0, 360.0);
+        double true_heading = course;
+
+        bool gps_tick = tick % GPS_EVERY_TICKS == 0;
+        if (gps_tick) {
+            EnuPoint noisy = {truth.east + gps_noise(rng), truth.north + gps_noise(rng), 0.0f};
+            GeoPosition position = frame.to_geodetic(noisy);
+            GpsFix &fix = gps_sample.value;
+            snprintf(fix.time, sizeof(fix.time), "%09.2f", t);
+            fix.latitude = position.latitude;
+            fix.longitude = position.longitude;
+            fix.altitude_agl = position.altitude;
+            fix.speed = static_cast<float>(speed * 3600.0 / 1852.0);
+            fix.course = static_cast<float>(course);
+            fix.fix_quality = 1;
+            fix.satellites = 8;
+            gps_sample.timestamp_ns = now_ns;
+            gps_sample.sequence++;
+            last_gps = noisy;
+        }
+
+        double measured_heading = std::fmod(true_heading + compass_noise(rng) + 360.0, 360.0);
+        compass_sample.value.heading = static_cast<float>(measured_heading);
+        compass_sample.timestamp_ns = now_ns;
+        compass_sample.sequence++;
+
+        auto start = clock::now();
+        estimator.update(gps_sample, compass_sample, now_ns);
+        double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+        (gps_tick ? gps_timing : predict_timing).samples_ns.push_back(ns);
+
+        // Skip the settling phase
+        if (tick < 500) continue;
+        EnuPoint estimate = frame.to_enu(estimator.get_position());
+        double raw_e = last_gps.east - truth.east, raw_n = last_gps.north - truth.north;
+        double est_e = estimate.east - truth.east, est_n = estimate.north - truth.north;
+        raw_square_sum += raw_e * raw_e + raw_n * raw_n;
+        filtered_square_sum += est_e * est_e + est_n * est_n;
+
+        double raw_heading_error = std::remainder(measured_heading - true_heading, 360.0);
+        double filtered_heading_error = std::remainder(estimator.get_heading() - true_heading, 360.0);
+        raw_heading_square_sum += raw_heading_error * raw_heading_error;
+        filtered_heading_square_sum += filtered_heading_error * filtered_heading_error;
+        error_samples++;
+    }
+
+    predict_timing.print("predict only:");
+    gps_timing.print("predict + GPS:");
+    printf("budget:         %8d ns/step\n", 100000);
+    printf("position RMS error: raw GPS %.2f m, estimate %.2f m\n",
+           std::sqrt(raw_square_sum / error_samples), std::sqrt(filtered_square_sum / error_samples));
+    printf("heading RMS error:  raw compass %.2f deg, estimate %.2f deg\n",
+           std::sqrt(raw_heading_square_sum / error_samples), std::sqrt(filtered_heading_square_sum / error_samples));
+    return 0;
+}
@@ -0,0 +1,77 @@
+// Cost of recording one control tick with the FlightRecorder, plus a check that the log reads back in
+// order after wrapping around, across sessions and with a record torn by a crash
+// Usage: flight_recorder_bench [records] [log file]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "FlightRecorder.h"
+
+static const size_t CAPACITY = 1 << 16;
+
+int main(int argc, char **argv) {
+    const int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    const std::string path = argc > 2 ? argv[2] : "/tmp/flight_recorder_bench.log";
+    remove(path.c_str());
+
+    FlightRecorder recorder;
+    std::string error;
+    if (!recorder.open(path, CAPACITY, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    FlightRecord record;
+    memset(&record, 0, sizeof(record));
+    std::vector<double> samples_ns;
+    samples_ns.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        record.tick_ns = i * 14000000LL;
+        record.errors[0] = static_cast<float>(i);
+        record.channels[0] = static_cast<uint16_t>(1024 + i % 100);
+        auto start = std::chrono::steady_clock::now();
+        recorder.append(record);
+        samples_ns.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    std::sort(samples_ns.begin(), samples_ns.end());
+    double total = 0;
+    for (double ns : samples_ns) total += ns;
+    printf("append          %8.0f ns/record mean, p99 %.0f ns, max %.0f ns (%d records of %zu bytes)\n",
+           total / count, samples_ns[count * 99 / 100], samples_ns.back(), count, sizeof(FlightRecord));
+
+    // Second session continues the ring, its second record is torn as by a crash
+    recorder.close();
+    if (!recorder.open(path, CAPACITY, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    for (int i = 0; i < 3; ++i) recorder.append(record);
+    recorder.close();
+    {
+        FILE *file = fopen(path.c_str(), "r+b");
+        uint64_t torn_sequence = static_cast<uint64_t>(count) + 2;
+        long offset = 64 + static_cast<long>(((torn_sequence - 1) % CAPACITY) * sizeof(FlightRecord));
+        uint64_t zero = 0;
+        fseek(file, offset, SEEK_SET);
+        fwrite(&zero, sizeof(zero), 1, file);
+        fclose(file);
+    }
+
+    std::vector<FlightRecord> records;
+    if (!FlightRecorder::read_file(path, records, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    bool ordered = true;
+    for (size_t i = 1; i < records.size(); ++i) ordered = ordered && records[i].sequence > records[i - 1].sequence;
+    size_t expected = std::min<size_t>(count + 3, CAPACITY) - 1;
+    bool sessions = !records.empty() && records.back().session == 2 && records.front().session == 1;
+    printf("read back:      %zu records (expected %zu), %s, sessions %s\n", records.size(), expected,
+           ordered ? "in order" : "NOT in order", sessions ? "1 and 2" : "WRONG");
+    remove(path.c_str());
+    return records.size() == expected && ordered && sessions ? 0 : 1;
+}
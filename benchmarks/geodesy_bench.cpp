@@ -0,0 +1,74 @@
+// Cost of the double precision distance/bearing path versus the former float path,
+// plus the position quantization each representation gives at the test latitude
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "Geodesy.h"
+
+// Former ControlLoop implementation, kept here as the reference
+static float float_distance(float lat1, float lon1, float lat2, float lon2) {
+    constexpr float R = 6371000.0;
+    float dlat = (lat2 - lat1) * M_PI / 180.0;
+    float dlon = (lon2 - lon1) * M_PI / 180.0;
+    float a = std::sin(dlat / 2) * std::sin(dlat / 2) +
+              std::cos(lat1 * M_PI / 180.0) * std::cos(lat2 * M_PI / 180.0) *
+                  std::sin(dlon / 2) * std::sin(dlon / 2);
+    float c = 2 * std::atan2(std::sqrt(a), std::sqrt(1 - a));
+    return R * c;
+}
+
+static float float_bearing(float lat1, float lon1, float lat2, float lon2) {
+    float dlon = (lon2 - lon1) * M_PI / 180.0;
+    lat1 = lat1 * M_PI / 180.0;
+    lat2 = lat2 * M_PI / 180.0;
+    float y = std::sin(dlon) * std::cos(lat2);
+    float x = std::cos(lat1) * std::sin(lat2) - std::sin(lat1) * std::cos(lat2) * std::cos(dlon);
+    float bearing = std::atan2(y, x) * 180.0 / M_PI;
+    return fmod(bearing + 360.0, 360.0);
+}
+
+int main(int argc, char **argv) {
+    const int iterations = argc > 1 ? atoi(argv[1]) : 1000000;
+    const double base_lat = 51.9607;
+    const double base_lon = 7.6261;
+
+    // Pairs spread over a few hundred meters, like a control loop error computation
+    const int PAIRS = 64;
+    GeoPosition from[PAIRS], to[PAIRS];
+    for (int i = 0; i < PAIRS; ++i) {
+        from[i] = {base_lat + i * 1e-5, base_lon - i * 1.3e-5, 0.0f};
+        to[i] = {base_lat - i * 2.1e-5, base_lon + i * 0.7e-5, 0.0f};
+    }
+
+    typedef std::chrono::steady_clock clock;
+    volatile double sink = 0;
+
+    auto start = clock::now();
+    for (int n = 0; n < iterations; ++n) {
+        const GeoPosition &a = from[n % PAIRS];
+        const GeoPosition &b = to[n % PAIRS];
+        sink = sink + float_distance(a.latitude, a.longitude, b.latitude, b.longitude)
+                    + float_bearing(a.latitude, a.longitude, b.latitude, b.longitude);
+    }
+    double float_s = std::chrono::duration<double>(clock::now() - start).count();
+
+    start = clock::now();
+    for (int n = 0; n < iterations; ++n) {
+        const GeoPosition &a = from[n % PAIRS];
+        const GeoPosition &b = to[n % PAIRS];
+        sink = sink + geo_distance(a, b) + geo_bearing(a, b);
+    }
+    double double_s = std::chrono::duration<double>(clock::now() - start).count();
+
+    // Spacing between adjacent representable latitudes, in meters
+    const double meters_per_degree = 6371000.0 * M_PI / 180.0;
+    float lat_f = static_cast<float>(base_lat);
+    double float_step = (std::nextafter(lat_f, 90.0f) - lat_f) * meters_per_degree;
+    double double_step = (std::nextafter(base_lat, 90.0) - base_lat) * meters_per_degree;
+
+    printf("float distance+bearing:  %8.1f ns/call\n", float_s * 1e9 / iterations);
+    printf("double distance+bearing: %8.1f ns/call (%.2fx)\n", double_s * 1e9 / iterations, double_s / float_s);
+    printf("latitude quantization at %.4f°: float %.3f m, double %.3g m\n", base_lat, float_step, double_step);
+    return 0;
+}
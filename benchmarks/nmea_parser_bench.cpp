@@ -0,0 +1,129 @@
+// Sentences per second of NmeaParser versus the former sscanf/atof based parsing in GPS::process_gps_data()
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include "NmeaParser.h"
+
+static const char *SENTENCES[] = {
+    "$GNRMC,123519.00,A,4807.03812,N,01131.00046,E,0.022,84.4,230394,,,A*7C",
+    "$GNGGA,123519.00,4807.03812,N,01131.00046,E,1,08,0.9,545.4,M,46.9,M,,*47",
+    "$GNRMC,123520.00,A,4807.03901,N,01131.00112,E,1.534,91.2,230394,,,A*70",
+    "$GNGGA,123520.00,4807.03901,N,01131.00112,E,2,12,0.7,545.9,M,46.9,M,,*4B",
+};
+static const int SENTENCE_COUNT = sizeof(SENTENCES) / sizeof(SENTENCES[0]);
+
+// Former implementation, kept here as the reference
+static float legacy_convert_to_decimal_degrees(const char *coord, char direction) {
+    if (coord == nullptr || strlen(coord) < 4 || !(direction == 'N' || direction == 'S' || direction == 'E' || direction == 'W')) {
+        throw std::invalid_argument("Invalid coordinate or direction");
+    }
+    float degrees = 0.0, minutes = 0.0;
+    if (direction == 'E' || direction == 'W') {
+        if (sscanf(coord, "%3f%f", &degrees, &minutes) != 2) throw std::invalid_argument("Failed to parse longitude coordinate");
+    } else {
+        if (sscanf(coord, "%2f%f", &degrees, &minutes) != 2) throw std::invalid_argument("Failed to parse latitude coordinate");
+    }
+    float decimal = degrees + (minutes / 60.0);
+    if (direction == 'S' || direction == 'W') decimal = -decimal;
+    return decimal;
+}
+
+static bool legacy_parse(const char *sentence, float &lat, float &lon) {
+    try {
+        if (strstr(sentence, "$GNRMC") != nullptr) {
+            char time_buf[11], lat_buf[11], lon_buf[12], speed_buf[8], cog_buf[8], date_buf[7];
+            char ns = 0, ew = 0, status = 0;
+            sscanf(sentence, "$GNRMC,%10[^,],%c,%10[^,],%c,%11[^,],%c,%7[^,],%7[^,],%6[^,]",
+                   time_buf, &status, lat_buf, &ns, lon_buf, &ew, speed_buf, cog_buf, date_buf);
+            if (status != 'A' || strlen(time_buf) == 0) return false;
+            lat = legacy_convert_to_decimal_degrees(lat_buf, ns);
+            lon = legacy_convert_to_decimal_degrees(lon_buf, ew);
+            volatile float speed = atof(speed_buf);
+            volatile float course = atof(cog_buf);
+            (void) speed;
+            (void) course;
+            return true;
+        } else if (strstr(sentence, "$GNGGA") != nullptr) {
+            char time_buf[11], lat_buf[11], lon_buf[12], alt_buf[8], geoid_buf[8];
+            char ns = 0, ew = 0;
+            int fix_quality = 0, satellites = 0;
+            float hdop = 0.0;
+            int parsed = sscanf(sentence, "$GNGGA,%10[^,],%10[^,],%c,%11[^,],%c,%d,%d,%f,%7[^,],M,%7[^,],M",
+                                time_buf, lat_buf, &ns, lon_buf, &ew, &fix_quality, &satellites, &hdop, alt_buf, geoid_buf);
+            if (parsed < 10) return false;
+            lat = legacy_convert_to_decimal_degrees(lat_buf, ns);
+            lon = legacy_convert_to_decimal_degrees(lon_buf, ew);
+            volatile float altitude = atof(alt_buf) - atof(geoid_buf);
+            (void) altitude;
+            return true;
+        }
+    } catch (const std::exception &) {
+    }
+    return false;
+}
+
+static bool parser_parse(const NmeaSentence &sentence, double &lat, double &lon) {
+    if (strncmp(sentence.data, "$GNRMC", 6) == 0) {
+        NmeaRmc rmc;
+        if (!NmeaParser::parse_rmc(sentence, rmc) || !rmc.active) return false;
+        lat = rmc.latitude;
+        lon = rmc.longitude;
+        return true;
+    } else {
+        NmeaGga gga;
+        if (!NmeaParser::parse_gga(sentence, gga) || !gga.has_position) return false;
+        lat = gga.latitude;
+        lon = gga.longitude;
+        return true;
+    }
+}
+
+int main(int argc, char **argv) {
+    const int iterations = argc > 1 ? atoi(argv[1]) : 200000;
+
+    NmeaSentence sentences[SENTENCE_COUNT];
+    for (int i = 0; i < SENTENCE_COUNT; ++i) {
+        sentences[i].data = SENTENCES[i];
+        sentences[i].length = strlen(SENTENCES[i]);
+        sentences[i].timestamp_ns = 0;
+    }
+
+    // Both must agree before timing means anything
+    for (int i = 0; i < SENTENCE_COUNT; ++i) {
+        float legacy_lat = 0, legacy_lon = 0;
+        double lat = 0, lon = 0;
+        if (!legacy_parse(SENTENCES[i], legacy_lat, legacy_lon) || !parser_parse(sentences[i], lat, lon) ||
+            std::fabs(lat - legacy_lat) > 1e-5 || std::fabs(lon - legacy_lon) > 1e-5) {
+            std::cerr << "Parsers disagree on: " << SENTENCES[i] << std::endl;
+            return 1;
+        }
+    }
+
+    typedef std::chrono::steady_clock clock;
+    volatile double sink = 0;
+
+    auto start = clock::now();
+    for (int n = 0; n < iterations; ++n) {
+        float lat, lon;
+        legacy_parse(SENTENCES[n % SENTENCE_COUNT], lat, lon);
+        sink = sink + lat;
+    }
+    double legacy_s = std::chrono::duration<double>(clock::now() - start).count();
+
+    start = clock::now();
+    for (int n = 0; n < iterations; ++n) {
+        double lat, lon;
+        parser_parse(sentences[n % SENTENCE_COUNT], lat, lon);
+        sink = sink + lat;
+    }
+    double parser_s = std::chrono::duration<double>(clock::now() - start).count();
+
+    printf("sscanf parser:  %12.0f sentences/s (%7.3f us/sentence)\n", iterations / legacy_s, legacy_s * 1e6 / iterations);
+    printf("NmeaParser:     %12.0f sentences/s (%7.3f us/sentence)\n", iterations / parser_s, parser_s * 1e6 / iterations);
+    printf("speedup:        %12.1fx\n", legacy_s / parser_s);
+    return 0;
+}
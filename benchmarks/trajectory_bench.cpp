@@ -0,0 +1,174 @@
+// Cost of one temporary target per control tick: the former per-tick geodesic computation versus
+// the trajectory compiled when the leg is planned, with constant speeds (checked against the former
+// computation) and with the jerk limited motion profiles the control loop uses
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "Geodesy.h"
+#include "Trajectory.h"
+
+// Former ControlLoop implementation, kept here as the reference
+static float float_distance(float lat1, float lon1, float lat2, float lon2) {
+    constexpr float R = 6371000.0;
+    float dlat = (lat2 - lat1) * M_PI / 180.0;
+    float dlon = (lon2 - lon1) * M_PI / 180.0;
+    float a = std::sin(dlat / 2) * std::sin(dlat / 2) +
+              std::cos(lat1 * M_PI / 180.0) * std::cos(lat2 * M_PI / 180.0) *
+                  std::sin(dlon / 2) * std::sin(dlon / 2);
+    float c = 2 * std::atan2(std::sqrt(a), std::sqrt(1 - a));
+    return R * c;
+}
+
+static float float_bearing(float lat1, float lon1, float lat2, float lon2) {
+    float dlon = (lon2 - lon1) * M_PI / 180.0;
+    lat1 = lat1 * M_PI / 180.0;
+    lat2 = lat2 * M_PI / 180.0;
+    float y = std::sin(dlon) * std::cos(lat2);
+    float x = std::cos(lat1) * std::sin(lat2) - std::sin(lat1) * std::cos(lat2) * std::cos(dlon);
+    float bearing = std::atan2(y, x) * 180.0 / M_PI;
+    return fmod(bearing + 360.0, 360.0);
+}
+
+struct Leg {
+    GeoPosition start, end;
+    float start_heading, end_heading;
+    float speed, altitude_speed, yaw_speed;
+};
+
+struct Target {
+    float latitude, longitude, altitude, heading;
+};
+
+static Target former_temporary_target(const Leg &leg, float elapsed_time_s) {
+    Target target;
+    float start_latitude = leg.start.latitude, start_longitude = leg.start.longitude;
+    float target_latitude = leg.end.latitude, target_longitude = leg.end.longitude;
+
+    float distance_to_travel = (leg.speed * 1000.0 / 3600.0) * elapsed_time_s;
+    float total_distance = float_distance(start_latitude, start_longitude, target_latitude, target_longitude);
+    if (distance_to_travel >= total_distance) {
+        target.latitude = target_latitude;
+        target.longitude = target_longitude;
+    } else {
+        float target_bearing = float_bearing(start_latitude, start_longitude, target_latitude, target_longitude);
+        constexpr float R = 6371000.0;
+        float delta_lat = (distance_to_travel / R) * (180.0 / M_PI) * std::cos(target_bearing * M_PI / 180.0);
+        float delta_lon = (distance_to_travel / R) * (180.0 / M_PI) * std::sin(target_bearing * M_PI / 180.0) / std::cos(start_latitude * M_PI / 180.0);
+        target.latitude = start_latitude + delta_lat;
+        target.longitude = start_longitude + delta_lon;
+    }
+
+    float altitude_to_climb = elapsed_time_s * (leg.altitude_speed * 1000.0 / 3600.0);
+    if (leg.end.altitude < leg.start.altitude) {
+        target.altitude = std::max(leg.start.altitude - altitude_to_climb, leg.end.altitude);
+    } else {
+        target.altitude = std::min(leg.start.altitude + altitude_to_climb, leg.end.altitude);
+    }
+
+    float start_heading = leg.start_heading, target_heading = leg.end_heading;
+    float heading_to_rotate = elapsed_time_s * leg.yaw_speed;
+    float clockwiseAngle = fmod(target_heading - start_heading + 360.0, 360.0);
+    float counterClockwiseAngle = fmod(start_heading - target_heading + 360.0, 360.0);
+    if (clockwiseAngle <= counterClockwiseAngle) {
+        target.heading = start_heading + heading_to_rotate;
+        float adjusted_target_heading = target_heading;
+        if (target_heading < start_heading) adjusted_target_heading += 360.0;
+        if (target.heading > adjusted_target_heading) target.heading = adjusted_target_heading;
+        target.heading = fmod(target.heading, 360.0);
+    } else {
+        target.heading = start_heading - heading_to_rotate;
+        float adjusted_target_heading = target_heading;
+        if (target_heading > start_heading) adjusted_target_heading -= 360.0;
+        if (target.heading < adjusted_target_heading) target.heading = adjusted_target_heading;
+        target.heading = fmod(target.heading + 360.0, 360.0);
+    }
+    return target;
+}
+
+static double time_compiled(const Trajectory *trajectories, int legs, int ticks, int ticks_per_leg, float tick_s,
+                            volatile double &sink) {
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < ticks; ++n) {
+        float t = (n % ticks_per_leg) * tick_s;
+        TrajectorySample sample;
+        trajectories[n / ticks_per_leg % legs].evaluate(t, sample);
+        sink = sink + sample.position.east + sample.position.north + sample.position.up + sample.heading;
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    const int ticks = argc > 1 ? atoi(argv[1]) : 1000000;
+    const float TICK_S = 0.014f;            // Same control period as main.cpp
+    const int TICKS_PER_LEG = 20000;        // 280 s, every leg gets flown to its end
+
+    // Legs of 50 m to 1.6 km in all directions, with climbs, sinks and turns both ways
+    const int LEGS = 32;
+    const GeoPosition base = {51.9607, 7.6261, 10.0f};
+    LocalFrame frame(base);
+    Leg legs[LEGS];
+    Trajectory constant[LEGS];
+    Trajectory limited[LEGS];
+    const TrajectoryLimits unlimited = {{0.0, 0.0}, {0.0, 0.0}, {0.0, 0.0}};
+    const TrajectoryLimits limits = {{2.0, 4.0}, {1.0, 2.0}, {45.0, 180.0}};   // As in ControlLoop.h
+    for (int i = 0; i < LEGS; ++i) {
+        double angle = i * 2.0 * M_PI / LEGS;
+        double length = 50.0 * (1 + i % 32);
+        EnuPoint end_enu = {length * std::sin(angle), length * std::cos(angle), 10.0f + (i % 5) * 7.0f};
+        Leg &leg = legs[i];
+        leg.start = base;
+        leg.end = frame.to_geodetic(end_enu);
+        leg.start_heading = std::fmod(i * 37.0f, 360.0f);
+        leg.end_heading = std::fmod(i * 113.0f, 360.0f);
+        leg.speed = 20.0f + i % 4 * 5.0f;
+        leg.altitude_speed = 3.6f;
+        leg.yaw_speed = 10.0f;
+
+        EnuPoint start_enu = {0.0, 0.0, base.altitude};
+        constant[i] = Trajectory::compile(start_enu, end_enu, leg.start_heading, leg.end_heading,
+                                          leg.speed, leg.altitude_speed, leg.yaw_speed, unlimited);
+        limited[i] = Trajectory::compile(start_enu, end_enu, leg.start_heading, leg.end_heading,
+                                         leg.speed, leg.altitude_speed, leg.yaw_speed, limits);
+    }
+
+    typedef std::chrono::steady_clock clock;
+    volatile double sink = 0;
+
+    auto start = clock::now();
+    for (int n = 0; n < ticks; ++n) {
+        float t = (n % TICKS_PER_LEG) * TICK_S;
+        Target target = former_temporary_target(legs[n / TICKS_PER_LEG % LEGS], t);
+        sink = sink + target.latitude + target.longitude + target.altitude + target.heading;
+    }
+    double former_s = std::chrono::duration<double>(clock::now() - start).count();
+
+    double constant_s = time_compiled(constant, LEGS, ticks, TICKS_PER_LEG, TICK_S, sink);
+    double limited_s = time_compiled(limited, LEGS, ticks, TICKS_PER_LEG, TICK_S, sink);
+
+    // Agreement with the former path (headings compared modulo 360)
+    double max_position_error = 0, max_heading_error = 0;
+    for (int i = 0; i < LEGS; ++i) {
+        for (int n = 0; n < TICKS_PER_LEG; n += 50) {
+            float t = n * TICK_S;
+            Target former = former_temporary_target(legs[i], t);
+            TrajectorySample sample;
+            constant[i].evaluate(t, sample);
+
+            GeoPosition former_position = {former.latitude, former.longitude, former.altitude};
+            EnuPoint former_enu = frame.to_enu(former_position);
+            double east = former_enu.east - sample.position.east, north = former_enu.north - sample.position.north;
+            max_position_error = std::max(max_position_error, std::sqrt(east * east + north * north));
+            double heading_error = std::fabs(std::remainder(former.heading - sample.heading, 360.0));
+            max_heading_error = std::max(max_heading_error, heading_error);
+        }
+    }
+
+    printf("former per-tick:   %7.1f ns/tick\n", former_s * 1e9 / ticks);
+    printf("compiled constant: %7.1f ns/tick (%.1fx)\n", constant_s * 1e9 / ticks, former_s / constant_s);
+    printf("compiled S-curve:  %7.1f ns/tick (%.1fx)\n", limited_s * 1e9 / ticks, former_s / limited_s);
+    printf("max difference:    %.2f m (float lat/lon of the former path), %.4f deg heading\n",
+           max_position_error, max_heading_error);
+    return sink == 0 ? 1 : 0;
+}
@@ -6,9 +6,10 @@
 #include "Connector.h"
 #include <thread>
 #include <chrono>
-#include "SBUS.h"
+#include "SbusRadio.h"
 #include "serialib.h"
 #include <mutex>
+#include <atomic>
 #include <fstream>
 #include <iostream>
 #include <cstdlib>
@@ -18,7 +19,12 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <termios.h>
+#include "Compass.h"
 #include "ControlLoop.h"
+#include "GPSModule.h"
+#include "MonotonicClock.h"
+#include "Scheduler.h"
+#include "TelemetryPublisher.h"
 
 
 using namespace std;
@@ -32,17 +38,25 @@ using std::chrono::milliseconds;
 
 #define SERIAL_PORT "/dev/ttyUSB2"
 
+#define SBUS_FRAME_PERIOD_US 7000   // SBUS frame period: 7 ms (high speed) or 14 ms (normal speed)
+#define CONTROL_PERIOD_US 14000     // Period of the position controller
+#define STATUS_PERIOD_US 2000000    // Period of the status output
+#define PARAMETER_FILE "parameters.json"     // Gains, thresholds and rates, overrides the defaults in ParameterStore.cpp
+#define FLIGHT_LOG_FILE "flight.log"         // Ring of the last control ticks, decode with tools/flight_log_to_csv
+
 bool remoteInactive = false;
-static auto lastWrite = steady_clock::now();
-static auto lastSBUSwrite = steady_clock::now();
 
-static SBUS sbus;
+static SbusRadio radio("/dev/ttyAMA1");
 static auto lastSBUSchange = steady_clock::now();
 sbus_packet_t lastPacket;
+static std::mutex packetMutex;     // Protects remote state shared between the SBUS thread and the scheduler
+static std::atomic<int64_t> lastFrameLatencyUs(0);
+static std::atomic<int64_t> maxFrameLatencyUs(0);
 
-ControlLoop control_loop(66.0, 66.0, 33.0, 7.33);   // k_lat, k_lon = 66 corresponds full throttle when deviation is 10 meters
-                                                    // k_alt = 33 corresponds full throttle when deviation is 20 meters
-                                                    // k_yaw = 73.3 corresponds full throttle when deviation is 90°
+static GPS gps;
+static Compass compass;
+ControlLoop control_loop(gps, compass);
+static FlightRecorder flightRecorder;
 
 
 sbus_packet_t getControlSignals() {
@@ -74,6 +88,7 @@ static void onPacket(const sbus_packet_t &packet)
     static auto lastPrint = steady_clock::now();
     auto now = steady_clock::now();
 
+    std::unique_lock<std::mutex> lock(packetMutex);
     bool change = false;
     for (int i = 0; i < 16; ++i) {
         if (packet.channels[i] != lastPacket.channels[i]) {
@@ -85,7 +100,6 @@ static void onPacket(const sbus_packet_t &packet)
     }
 
     if(change){
-        control_loop.abort();
         lastSBUSchange = now;
         remoteInactive = false;
         for (int i = 0; i < 16; ++i)
@@ -94,6 +108,8 @@ static void onPacket(const sbus_packet_t &packet)
         lastPacket.ch18 = packet.ch18;
         lastPacket.frameLost = packet.frameLost;
         lastPacket.failsafe = packet.failsafe;
+        lock.unlock();
+        control_loop.abort();
 
     } else if (now - lastSBUSchange > milliseconds(5000) && !remoteInactive) {
         remoteInactive = true;
@@ -102,18 +118,32 @@ static void onPacket(const sbus_packet_t &packet)
 }
 
 
-int main() {
+int main(int argc, char *argv[]) {
 
-    // SBUS initalisieren
+    // Parameter laden, optional file given as first argument
+    std::string parameterError;
+    if (!control_loop.get_parameters().load_file(argc > 1 ? argv[1] : PARAMETER_FILE, parameterError)) {
+        std::cerr << "Invalid parameters: " << parameterError << std::endl;
+        return 1;
+    }
+    compass.set_sample_rate(static_cast<float>(control_loop.get_parameters().get().compass_sample_rate));
+
+    // Flight recorder, flying without it is better than not flying
+    std::string recorderError;
+    if (flightRecorder.open(FLIGHT_LOG_FILE, FlightRecorder::DEFAULT_CAPACITY, recorderError)) {
+        control_loop.set_flight_recorder(&flightRecorder);
+        std::cout << "Recording session " << flightRecorder.get_session() << " to " << FLIGHT_LOG_FILE << std::endl;
+    } else {
+        std::cerr << "Flight recorder disabled: " << recorderError << std::endl;
+    }
 
-    string ttyPath = "/dev/ttyAMA1";
+    // SBUS initalisieren
 
-    sbus.onPacket(onPacket);
+    radio.set_packet_listener(onPacket);
 
-    sbus_err_t err = sbus.install(ttyPath.c_str(), true);  // false for non-blocking
-    if (err != SBUS_OK)
+    if (!radio.init())
     {
-        cerr << "SBUS install error: " << err << endl;
+        cerr << "SBUS install error: " << radio.get_last_error() << endl;
         cerr << "SKIPPING SBUS. FOR DEVELOPMENT ONLY!" << endl;
         // return err;
 
@@ -133,8 +163,6 @@ int main() {
     std::cerr << "Gestartet" << std::endl;
    
     lastSBUSchange = steady_clock::now();
-    lastWrite = steady_clock::now();
-    lastSBUSwrite = steady_clock::now();
 
     if (!control_loop.init()) {
         std::cerr << "Failed to initialize GPS or Compass." << std::endl;
@@ -142,42 +170,76 @@ int main() {
     }
     
     // Netzwerk Thread starten
+    TelemetryPublisher telemetryPublisher(control_loop, control_loop.get_parameters().get().udp_telemetry_rate);
+    if (!telemetryPublisher.start()) {
+        std::cerr << "Failed to start UDP telemetry." << std::endl;
+        return 1;
+    }
+
     Connector connector(control_loop, 1337);
+    connector.setTelemetryPublisher(&telemetryPublisher);
     if (!connector.start()) {
         std::cerr << "Failed to start connector." << std::endl;
         return 1;
     }
 
-    //Mainloop
-    while(true) {
+    // SBUS ingest thread: sleeps until the receiver delivers bytes
+    std::thread sbusThread([] {
+        if (!radio.run()) {
+            cerr << "SBUS reactor stopped with error: " << radio.get_last_error() << endl;
+        }
+    });
+    sbusThread.detach();
 
-        auto now = steady_clock::now();
+    // Mainloop: compute -> write, paced by absolute deadlines
+    Scheduler scheduler(std::chrono::microseconds(SBUS_FRAME_PERIOD_US));
 
-        if(now - lastWrite > milliseconds(2000)) {
-            std::cout << "Control loop state: " << static_cast<int>(control_loop.get_position_control_state()) << std::endl;
-            lastWrite = now;
-        }
-        
-        sbus_err_t result = sbus.read();
+    scheduler.add_stage("control", std::chrono::microseconds(CONTROL_PERIOD_US), [] {
         control_loop.update_signals();
+    });
 
-        if (result == SBUS_OK) {
-            // printf("Read successful: SBUS_OK\n");
-        } else if (result == SBUS_ERR_DESYNC) {
-            printf("SBUS Read error: SBUS_ERR_DESYNC (Bad packet)\n");
-        } else {
-            // printf("SBUS Read error: %d\n", result);
-        }
-
+    scheduler.add_stage("sbus_write", std::chrono::microseconds(SBUS_FRAME_PERIOD_US), [] {
+        std::unique_lock<std::mutex> lock(packetMutex);
         if (!remoteInactive) {
             // Write last packet received from remote control
-            sbus.write(lastPacket);
+            sbus_packet_t remotePacket = lastPacket;
+            lock.unlock();
+            radio.write(remotePacket);
+
+            // Frame-to-output latency of the remote control packet
+            int64_t arrival_ns = radio.get_last_packet_ns();
+            if (arrival_ns != 0) {
+                int64_t latency_us = (monotonic_ns() - arrival_ns) / 1000;
+                lastFrameLatencyUs = latency_us;
+                if (latency_us > maxFrameLatencyUs) maxFrameLatencyUs = latency_us;
+            }
         } else {
+            lock.unlock();
             sbus_packet_t controlPacket = getControlSignals();
-            sbus.write(controlPacket);
+            radio.write(controlPacket);
         }
-    }
+    });
+
+    scheduler.add_stage("status", std::chrono::microseconds(STATUS_PERIOD_US), [&scheduler] {
+        flightRecorder.flush();    // Write back the ticks recorded since the last status line
+        std::cout << "Control loop state: " << static_cast<int>(control_loop.get_position_control_state())
+                  << ", deadline misses: " << scheduler.get_deadline_misses()
+                  << ", SBUS frames: " << radio.get_packet_count()
+                  << " (desyncs: " << radio.get_error_count() << ")"
+                  << ", frame latency: " << lastFrameLatencyUs << " us (max " << maxFrameLatencyUs << " us)";
+        for (const auto &stage : scheduler.get_stage_stats()) {
+            if (stage.overruns > 0) {
+                std::cout << ", " << stage.name << " overruns: " << stage.overruns
+                          << " (max " << stage.max_runtime_us << " us)";
+            }
+        }
+        std::cout << std::endl;
+    });
+
+    scheduler.run();
 
+    radio.stop();
     connector.stop();
+    telemetryPublisher.stop();
     return 0;
 }
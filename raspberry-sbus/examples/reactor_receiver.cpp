@@ -0,0 +1,88 @@
+#include <iostream>
+#include <chrono>
+#include <ctime>
+#include "SBUS.h"
+#include "SbusReactor.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::cin;
+using std::string;
+using std::chrono::steady_clock;
+using std::chrono::milliseconds;
+
+static SBUS sbus;
+static SbusReactor reactor(sbus);
+
+static void onPacket(const sbus_packet_t &packet)
+{
+    static auto lastPrint = steady_clock::now();
+    auto now = steady_clock::now();
+
+    if (now - lastPrint > milliseconds(500))
+    {
+        // time between the data arriving and the packet being handled here
+        struct timespec arrival = reactor.lastPacketTime();
+        struct timespec handled;
+        clock_gettime(CLOCK_MONOTONIC, &handled);
+        long latencyUs = (handled.tv_sec - arrival.tv_sec) * 1000000L + (handled.tv_nsec - arrival.tv_nsec) / 1000;
+
+        for (int i = 0; i < 16; ++i)
+            cout << "ch" << i + 1 << ": " << packet.channels[i] << "\t";
+
+        cout << "latency: " << latencyUs << " us\t"
+             << "packets: " << reactor.packetCount() << "\t"
+             << "wakeups: " << reactor.wakeupCount();
+
+        if (packet.frameLost)
+            cout << "\tFrame lost";
+
+        if (packet.failsafe)
+            cout << "\tFailsafe active";
+
+        cout << endl;
+
+        lastPrint = now;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    cout << "SBUS reactor receiver example" << endl;
+
+    string ttyPath;
+
+    if (argc > 1)
+        ttyPath = argv[1];
+    else
+    {
+        cout << "Enter tty path: ";
+        cin >> ttyPath;
+    }
+
+    sbus.onPacket(onPacket);
+
+    sbus_err_t err = sbus.install(ttyPath.c_str(), false);  // the reactor waits, the tty must not block
+    if (err != SBUS_OK)
+    {
+        cerr << "SBUS install error: " << err << endl;
+        return err;
+    }
+
+    err = reactor.install();
+    if (err != SBUS_OK)
+    {
+        cerr << "SBUS reactor install error: " << err << endl;
+        return err;
+    }
+
+    cout << "SBUS installed" << endl;
+
+    // sleeps until data arrives, returns on a fatal error or reactor.stop()
+    err = reactor.run();
+
+    cerr << "SBUS error: " << err << endl;
+
+    return err;
+}
@@ -6,6 +6,7 @@ DecoderFSM::DecoderFSM()
         , _packetPos(0)
         , _lastPacket({0})
         , _packetCb(nullptr)
+        , _packetCount(0)
 {
     _lastPacket.failsafe = true;
     _lastPacket.frameLost = true;
@@ -51,6 +52,7 @@ sbus_err_t DecoderFSM::feed(const uint8_t buf[], int bufSize, bool *hadDesyncOut
                         decodePacket() == SBUS_OK)
                     {
                         hadDesync = false;  // clear desync if last packet was ok
+                        _packetCount++;
                         notifyCallback();
 
                         // receive next packet
@@ -136,6 +138,11 @@ const sbus_packet_t& DecoderFSM::lastPacket() const
     return _lastPacket;
 }
 
+uint32_t DecoderFSM::packetCount() const
+{
+    return _packetCount;
+}
+
 sbus_err_t DecoderFSM::onPacket(sbus_packet_cb cb)
 {
     _packetCb = cb;
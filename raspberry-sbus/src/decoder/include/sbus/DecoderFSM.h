@@ -18,6 +18,8 @@ public:
 
     const sbus_packet_t& lastPacket() const;
 
+    uint32_t packetCount() const;
+
 private:
     enum class State
     {
@@ -31,6 +33,7 @@ private:
 
     sbus_packet_t _lastPacket;
     sbus_packet_cb _packetCb;
+    uint32_t _packetCount;
 
     sbus_err_t verifyPacket();
     sbus_err_t decodePacket();
@@ -2,6 +2,7 @@
 #include "sbus/sbus_tty.h"
 #include "sbus/sbus_low_latency.h"
 #include "sbus/packet_decoder.h"
+#include <cerrno>
 
 SBUS::SBUS() noexcept
     : _fd(-1)
@@ -40,9 +41,11 @@ sbus_err_t SBUS::read()
 
     int nRead = sbus_read(_fd, _readBuf, READ_BUF_SIZE);
 
-    // TODO SBUS_OK if timeout, else error
-    if (nRead <= 0)
+    // timeout (blocking) or no data available (non-blocking)
+    if (nRead == 0 || (nRead < 0 && (errno == EAGAIN || errno == EINTR)))
         return SBUS_OK;
+    if (nRead < 0)
+        return SBUS_FAIL;
 
     bool hadDesync = false;
     _decoder.feed(_readBuf, nRead, &hadDesync);
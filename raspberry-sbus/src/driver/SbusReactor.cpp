@@ -0,0 +1,187 @@
+#include "SbusReactor.h"
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <cerrno>
+#include "sbus/sbus_tty.h"
+
+static int64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+SbusReactor::SbusReactor(SBUS &sbus) noexcept
+    : _sbus(sbus)
+    , _epollFd(-1)
+    , _wakeFd(-1)
+    , _running(false)
+    , _lastPacketNs(0)
+    , _packetCount(0)
+    , _wakeupCount(0)
+    , _desyncCount(0)
+{}
+
+SbusReactor::~SbusReactor() noexcept
+{
+    uninstall();
+}
+
+sbus_err_t SbusReactor::install()
+{
+    if (_sbus._fd < 0)
+        return SBUS_FAIL;
+
+    uninstall();
+
+    _epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (_epollFd < 0)
+        return SBUS_FAIL;
+
+    _wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_wakeFd < 0)
+    {
+        uninstall();
+        return SBUS_FAIL;
+    }
+
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = _sbus._fd;
+    if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, _sbus._fd, &ev) < 0)
+    {
+        uninstall();
+        return SBUS_FAIL;
+    }
+
+    ev.data.fd = _wakeFd;
+    if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, _wakeFd, &ev) < 0)
+    {
+        uninstall();
+        return SBUS_FAIL;
+    }
+
+    _running = true;
+    return SBUS_OK;
+}
+
+sbus_err_t SbusReactor::uninstall()
+{
+    if (_wakeFd >= 0)
+        close(_wakeFd);
+    if (_epollFd >= 0)
+        close(_epollFd);
+    _wakeFd = -1;
+    _epollFd = -1;
+    return SBUS_OK;
+}
+
+sbus_err_t SbusReactor::poll(int timeoutMs)
+{
+    if (_epollFd < 0)
+        return SBUS_FAIL;
+
+    struct epoll_event events[2];
+    int nEvents = epoll_wait(_epollFd, events, 2, timeoutMs);
+    if (nEvents < 0)
+        return errno == EINTR ? SBUS_OK : SBUS_FAIL;
+
+    // stamp as close to the wakeup as possible, before spending time on the read
+    int64_t arrivalNs = monotonicNs();
+
+    sbus_err_t result = SBUS_OK;
+
+    for (int i = 0; i < nEvents; i++)
+    {
+        if (events[i].data.fd == _wakeFd)
+        {
+            uint64_t value;
+            while (::read(_wakeFd, &value, sizeof(value)) > 0) {}
+            continue;
+        }
+
+        if (events[i].events & (EPOLLERR | EPOLLHUP))
+            return SBUS_FAIL;
+
+        // level triggered: anything left over after one full buffer wakes us up again
+        int nRead = sbus_read(_sbus._fd, _sbus._readBuf, SBUS::READ_BUF_SIZE);
+        if (nRead < 0)
+            return (errno == EAGAIN || errno == EINTR) ? SBUS_OK : SBUS_FAIL;
+        if (nRead == 0)
+            continue;
+
+        _wakeupCount++;
+
+        // packets completed by this batch are delivered with its arrival time
+        int64_t previousNs = _lastPacketNs.load();
+        uint32_t packetsBefore = _sbus._decoder.packetCount();
+        _lastPacketNs = arrivalNs;
+
+        bool hadDesync = false;
+        _sbus._decoder.feed(_sbus._readBuf, nRead, &hadDesync);
+
+        uint32_t decoded = _sbus._decoder.packetCount() - packetsBefore;
+        if (decoded > 0)
+            _packetCount += decoded;
+        else
+            _lastPacketNs = previousNs;
+
+        if (hadDesync)
+        {
+            _desyncCount++;
+            result = SBUS_ERR_DESYNC;
+        }
+    }
+
+    return result;
+}
+
+sbus_err_t SbusReactor::run()
+{
+    while (_running)
+    {
+        sbus_err_t err = poll(-1);
+        if (err != SBUS_OK && err != SBUS_ERR_DESYNC)
+        {
+            _running = false;
+            return err;
+        }
+    }
+    return SBUS_OK;
+}
+
+void SbusReactor::stop()
+{
+    _running = false;
+    if (_wakeFd >= 0)
+    {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(_wakeFd, &one, sizeof(one));
+        (void) ignored;
+    }
+}
+
+struct timespec SbusReactor::lastPacketTime() const
+{
+    int64_t ns = _lastPacketNs.load();
+    struct timespec ts;
+    ts.tv_sec = (time_t) (ns / 1000000000LL);
+    ts.tv_nsec = (long) (ns % 1000000000LL);
+    return ts;
+}
+
+uint64_t SbusReactor::packetCount() const
+{
+    return _packetCount.load();
+}
+
+uint64_t SbusReactor::wakeupCount() const
+{
+    return _wakeupCount.load();
+}
+
+uint64_t SbusReactor::desyncCount() const
+{
+    return _desyncCount.load();
+}
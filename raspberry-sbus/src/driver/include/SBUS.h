@@ -56,6 +56,8 @@ public:
     const sbus_packet_t& lastPacket() const;
 
 private:
+    friend class SbusReactor;
+
     static constexpr int READ_BUF_SIZE = SBUS_PACKET_SIZE * 10;
 
     int _fd;
@@ -0,0 +1,65 @@
+#ifndef RPISBUS_SBUS_REACTOR_H
+#define RPISBUS_SBUS_REACTOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include "SBUS.h"
+
+/// Event-driven receiver for an installed SBUS object.
+/// Sleeps in epoll until the tty has data, then decodes everything available in one go.
+/// Every decoded packet is stamped with the CLOCK_MONOTONIC time the data was reported readable.
+class SbusReactor
+{
+public:
+    explicit SbusReactor(SBUS &sbus) noexcept;
+
+    virtual ~SbusReactor() noexcept;
+
+    /// Create the epoll instance and watch the SBUS tty.
+    /// Called after SBUS::install().
+    /// \return Error code or SBUS_OK
+    sbus_err_t install();
+
+    /// Release the epoll instance.
+    /// \return Error code or SBUS_OK (closing a closed reactor also gives SBUS_OK)
+    sbus_err_t uninstall();
+
+    /// Wait for data and process it.
+    /// \param timeoutMs Maximum time to wait in milliseconds, -1 waits forever
+    /// \return SBUS_ERR_DESYNC signaling a bad packet (not fatal), other error code or SBUS_OK (also on timeout)
+    sbus_err_t poll(int timeoutMs);
+
+    /// Call poll() until stop() is called or a fatal error occurs.
+    /// \return Error code or SBUS_OK if stopped
+    sbus_err_t run();
+
+    /// Make run() return. Safe to call from any thread.
+    void stop();
+
+    /// Arrival time of the last decoded packet (CLOCK_MONOTONIC).
+    /// Inside the packet callback this is the time of the packet being delivered.
+    /// \return Arrival time, zero if no packet was received yet
+    struct timespec lastPacketTime() const;
+
+    /// Number of decoded packets.
+    uint64_t packetCount() const;
+
+    /// Number of wakeups that had data to read.
+    uint64_t wakeupCount() const;
+
+    /// Number of read batches that contained a bad packet.
+    uint64_t desyncCount() const;
+
+private:
+    SBUS &_sbus;
+    int _epollFd;
+    int _wakeFd;
+    std::atomic<bool> _running;
+    std::atomic<int64_t> _lastPacketNs;
+    std::atomic<uint64_t> _packetCount;
+    std::atomic<uint64_t> _wakeupCount;
+    std::atomic<uint64_t> _desyncCount;
+};
+
+#endif //RPISBUS_SBUS_REACTOR_H
@@ -0,0 +1,104 @@
+#include "MultirotorModel.h"
+#include <cmath>
+
+static const double GRAVITY = 9.81;
+static const double DEG_TO_RAD = M_PI / 180.0;
+
+// Flight mode channel and the lowest value of the GPS hold mode (511 manual, 1024 altitude, 1541 hold)
+static const int FLIGHT_MODE_CHANNEL = 6;
+static const int GPS_HOLD_THRESHOLD = 1300;
+
+MultirotorConfig default_multirotor_config() {
+    MultirotorConfig config;
+    config.max_tilt = 25.0;                 // About 13 m/s top speed with the drag below
+    config.attitude_time_constant = 0.15;
+    config.drag = 0.35;
+    config.max_climb_rate = 3.0;
+    config.climb_time_constant = 0.3;
+    config.max_yaw_rate = 90.0;
+    config.yaw_time_constant = 0.1;
+    config.hold_tilt_per_speed = 5.0;
+    config.wind_east = 0.0;
+    config.wind_north = 0.0;
+    config.sbus_center = 1024;
+    config.sbus_range = 660;
+    return config;
+}
+
+MultirotorModel::MultirotorModel(const MultirotorConfig &config) : config(config) {
+    reset({0.0, 0.0, 0.0f}, 0.0);
+}
+
+void MultirotorModel::reset(const EnuPoint &position, double heading) {
+    state = MultirotorState();
+    state.position = position;
+    state.heading = heading;
+}
+
+double MultirotorModel::stick(uint16_t channel) const {
+    double value = (static_cast<int>(channel) - config.sbus_center) / static_cast<double>(config.sbus_range);
+    if (value > 1.0) return 1.0;
+    if (value < -1.0) return -1.0;
+    return value;
+}
+
+// Fraction of the way a first-order lag with time constant <tau> moves within <dt>
+static double lag(double dt, double tau) {
+    return tau > 0.0 ? dt / (tau + dt) : 1.0;
+}
+
+static double clamp(double value, double limit) {
+    if (value > limit) return limit;
+    if (value < -limit) return -limit;
+    return value;
+}
+
+void MultirotorModel::step(const sbus_packet_t &packet, double dt) {
+    if (dt <= 0.0) return;
+
+    double heading_rad = state.heading * DEG_TO_RAD;
+    double cos_heading = std::cos(heading_rad);
+    double sin_heading = std::sin(heading_rad);
+
+    // Tilt, climb rate and yaw rate commanded by the sticks or by the GPS hold of the flight controller
+    double roll_target, pitch_target, climb_target, yaw_rate_target;
+    if (packet.channels[FLIGHT_MODE_CHANNEL] >= GPS_HOLD_THRESHOLD) {
+        double forward_velocity = state.velocity_north * cos_heading + state.velocity_east * sin_heading;
+        double lateral_velocity = state.velocity_east * cos_heading - state.velocity_north * sin_heading;
+        roll_target = clamp(-lateral_velocity * config.hold_tilt_per_speed, config.max_tilt);
+        pitch_target = clamp(-forward_velocity * config.hold_tilt_per_speed, config.max_tilt);
+        climb_target = 0.0;
+        yaw_rate_target = 0.0;
+    } else {
+        roll_target = stick(packet.channels[0]) * config.max_tilt;
+        pitch_target = stick(packet.channels[1]) * config.max_tilt;
+        climb_target = stick(packet.channels[2]) * config.max_climb_rate;
+        yaw_rate_target = stick(packet.channels[3]) * config.max_yaw_rate;
+    }
+
+    double attitude_lag = lag(dt, config.attitude_time_constant);
+    state.roll += attitude_lag * (roll_target - state.roll);
+    state.pitch += attitude_lag * (pitch_target - state.pitch);
+    state.climb_rate += lag(dt, config.climb_time_constant) * (climb_target - state.climb_rate);
+    state.yaw_rate += lag(dt, config.yaw_time_constant) * (yaw_rate_target - state.yaw_rate);
+
+    // Tilt accelerates in the body frame, drag acts on the airspeed
+    double forward = GRAVITY * std::tan(state.pitch * DEG_TO_RAD);
+    double lateral = GRAVITY * std::tan(state.roll * DEG_TO_RAD);
+    double acceleration_east = forward * sin_heading + lateral * cos_heading - config.drag * (state.velocity_east - config.wind_east);
+    double acceleration_north = forward * cos_heading - lateral * sin_heading - config.drag * (state.velocity_north - config.wind_north);
+
+    // Semi-implicit Euler, stable for the step sizes of the simulation
+    state.velocity_east += acceleration_east * dt;
+    state.velocity_north += acceleration_north * dt;
+    state.position.east += state.velocity_east * dt;
+    state.position.north += state.velocity_north * dt;
+    state.position.up += static_cast<float>(state.climb_rate * dt);
+
+    state.heading = std::fmod(state.heading + state.yaw_rate * dt, 360.0);
+    if (state.heading < 0.0) state.heading += 360.0;
+}
+
+const MultirotorState &MultirotorModel::get_state() const {
+    return state;
+}
@@ -0,0 +1,60 @@
+#ifndef DRONE_MULTIROTOR_MODEL_H
+#define DRONE_MULTIROTOR_MODEL_H
+
+#include <cstdint>
+#include "Geodesy.h"
+#include "SBUS.h"
+
+// Flight characteristics of the simulated drone. In the altitude stabilized flight mode roll/pitch
+// sticks command a tilt angle, throttle a climb rate and yaw a yaw rate, each reached with a
+// first-order lag. In the GPS hold mode the flight controller ignores the sticks and tilts against
+// the ground speed until the drone stands still.
+struct MultirotorConfig {
+    double max_tilt;                    // Degrees at full roll/pitch stick
+    double attitude_time_constant;      // Seconds
+    double drag;                        // 1/s, horizontal acceleration per m/s of airspeed
+    double max_climb_rate;              // m/s at full throttle stick
+    double climb_time_constant;         // Seconds
+    double max_yaw_rate;                // Degrees/s at full yaw stick
+    double yaw_time_constant;           // Seconds
+    double hold_tilt_per_speed;         // Degrees of braking tilt per m/s in the GPS hold mode
+    double wind_east;                   // m/s
+    double wind_north;
+    int sbus_center;                    // Channel value of a centered stick
+    int sbus_range;                     // Channel steps from center to full stick
+};
+
+MultirotorConfig default_multirotor_config();
+
+// True state in a local East-North-Up frame
+struct MultirotorState {
+    EnuPoint position;
+    double velocity_east;       // m/s
+    double velocity_north;
+    double climb_rate;
+    double heading;             // Degrees [0, 360)
+    double yaw_rate;            // Degrees/s
+    double roll;                // Degrees, positive to the right
+    double pitch;               // Degrees, positive forward
+};
+
+// Point-mass model with heading, driven by the SBUS packets of the ControlLoop
+class MultirotorModel {
+public:
+    explicit MultirotorModel(const MultirotorConfig &config);
+
+    void reset(const EnuPoint &position, double heading);
+
+    // Advance by <dt> seconds with the steering and flight mode channels of <packet>
+    void step(const sbus_packet_t &packet, double dt);
+
+    const MultirotorState &get_state() const;
+
+private:
+    MultirotorConfig config;
+    MultirotorState state;
+
+    double stick(uint16_t channel) const;
+};
+
+#endif // DRONE_MULTIROTOR_MODEL_H
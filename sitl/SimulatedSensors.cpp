@@ -0,0 +1,100 @@
+#include "SimulatedSensors.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+static constexpr double MPS_TO_KNOTS = 3600.0 / 1852.0;
+
+SensorConfig default_sensor_config() {
+    SensorConfig config;
+    config.gps_rate = 5.0;
+    config.gps_position_noise = 0.5;
+    config.gps_altitude_noise = 1.0;
+    config.gps_velocity_noise = 0.1;
+    config.compass_rate = 100.0;
+    config.compass_noise = 1.0;
+    return config;
+}
+
+SimulatedSensors::SimulatedSensors(const GeoPosition &origin, const SensorConfig &config, uint32_t seed)
+    : config(config), local_frame(origin), random(seed), normal(0.0, 1.0),
+      gps_period_ns(static_cast<int64_t>(1e9 / config.gps_rate)),
+      compass_period_ns(static_cast<int64_t>(1e9 / config.compass_rate)),
+      next_gps_ns(0), next_compass_ns(0) {
+    memset(&gps_sample, 0, sizeof(gps_sample));
+    memset(&compass_sample, 0, sizeof(compass_sample));
+}
+
+void SimulatedSensors::update(const MultirotorState &state, int64_t now_ns) {
+    if (now_ns >= next_gps_ns) {
+        sample_gps(state, now_ns);
+        next_gps_ns = (next_gps_ns == 0 ? now_ns : next_gps_ns) + gps_period_ns;
+    }
+    if (now_ns >= next_compass_ns) {
+        sample_compass(state, now_ns);
+        next_compass_ns = (next_compass_ns == 0 ? now_ns : next_compass_ns) + compass_period_ns;
+    }
+}
+
+void SimulatedSensors::sample_gps(const MultirotorState &state, int64_t now_ns) {
+    EnuPoint measured = state.position;
+    measured.east += config.gps_position_noise * normal(random);
+    measured.north += config.gps_position_noise * normal(random);
+    measured.up += static_cast<float>(config.gps_altitude_noise * normal(random));
+    double velocity_east = state.velocity_east + config.gps_velocity_noise * normal(random);
+    double velocity_north = state.velocity_north + config.gps_velocity_noise * normal(random);
+
+    GpsFix &fix = gps_sample.value;
+    GeoPosition position = local_frame.to_geodetic(measured);
+    fix.latitude = position.latitude;
+    fix.longitude = position.longitude;
+    fix.altitude_agl = position.altitude;
+    fix.speed = static_cast<float>(std::sqrt(velocity_east * velocity_east + velocity_north * velocity_north) * MPS_TO_KNOTS);
+    double course = std::atan2(velocity_east, velocity_north) * 180.0 / M_PI;
+    fix.course = static_cast<float>(course < 0.0 ? course + 360.0 : course);
+    fix.fix_quality = 1;
+    fix.satellites = 10;
+
+    // The epoch time tells the consumers that a new fix arrived
+    int64_t milliseconds = (now_ns / 1000000) % (24 * 3600 * 1000);
+    char time[16];
+    snprintf(time, sizeof(time), "%02d%02d%02d.%03d", static_cast<int>(milliseconds / 3600000),
+             static_cast<int>(milliseconds / 60000 % 60), static_cast<int>(milliseconds / 1000 % 60),
+             static_cast<int>(milliseconds % 1000));
+    memcpy(fix.time, time, sizeof(fix.time));
+    fix.time[sizeof(fix.time) - 1] = '\0';
+
+    gps_sample.timestamp_ns = now_ns;
+    gps_sample.sequence++;
+}
+
+void SimulatedSensors::sample_compass(const MultirotorState &state, int64_t now_ns) {
+    double heading = std::fmod(state.heading + config.compass_noise * normal(random), 360.0);
+    if (heading < 0.0) heading += 360.0;
+
+    CompassSample &sample = compass_sample.value;
+    sample.heading = static_cast<float>(heading);
+    // Raw field the Compass driver turns into this heading
+    sample.x = static_cast<int16_t>(-1000.0 * std::sin(heading * M_PI / 180.0));
+    sample.y = static_cast<int16_t>(1000.0 * std::cos(heading * M_PI / 180.0));
+    sample.z = 0;
+
+    compass_sample.timestamp_ns = now_ns;
+    compass_sample.sequence++;
+}
+
+bool SimulatedSensors::init() {
+    return true;
+}
+
+Sample<GpsFix> SimulatedSensors::get_fix_sample() const {
+    return gps_sample;
+}
+
+Sample<CompassSample> SimulatedSensors::get_sample() const {
+    return compass_sample;
+}
+
+const LocalFrame &SimulatedSensors::frame() const {
+    return local_frame;
+}
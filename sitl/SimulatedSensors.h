@@ -0,0 +1,55 @@
+#ifndef DRONE_SIMULATED_SENSORS_H
+#define DRONE_SIMULATED_SENSORS_H
+
+#include <cstdint>
+#include <random>
+#include "Geodesy.h"
+#include "SensorInterfaces.h"
+#include "MultirotorModel.h"
+
+// Rates and noise of the simulated receivers
+struct SensorConfig {
+    double gps_rate;                    // Hz
+    double gps_position_noise;          // Meters, standard deviation per axis
+    double gps_altitude_noise;          // Meters
+    double gps_velocity_noise;          // m/s per axis
+    double compass_rate;                // Hz
+    double compass_noise;               // Degrees
+};
+
+SensorConfig default_sensor_config();
+
+// Replaces the GPS and Compass backends: samples the true state of the model at the receiver
+// rates, adds Gaussian noise and publishes them in the format of the real receivers (geodetic
+// position, speed in knots, course, heading in degrees).
+class SimulatedSensors : public PositionSource, public HeadingSource {
+public:
+    SimulatedSensors(const GeoPosition &origin, const SensorConfig &config, uint32_t seed);
+
+    // Produce the samples due at <now_ns> from the true state
+    void update(const MultirotorState &state, int64_t now_ns);
+
+    bool init() override;
+    Sample<GpsFix> get_fix_sample() const override;
+    Sample<CompassSample> get_sample() const override;
+
+    const LocalFrame &frame() const;
+
+private:
+    SensorConfig config;
+    LocalFrame local_frame;
+    std::mt19937 random;
+    std::normal_distribution<double> normal;
+
+    Sample<GpsFix> gps_sample;
+    Sample<CompassSample> compass_sample;
+    int64_t gps_period_ns;
+    int64_t compass_period_ns;
+    int64_t next_gps_ns;
+    int64_t next_compass_ns;
+
+    void sample_gps(const MultirotorState &state, int64_t now_ns);
+    void sample_compass(const MultirotorState &state, int64_t now_ns);
+};
+
+#endif // DRONE_SIMULATED_SENSORS_H
@@ -0,0 +1,221 @@
+// Software-in-the-loop simulation of the ControlLoop. The GPS, the Compass and the SBUS output are
+// replaced by a multirotor model and simulated receivers on a simulated clock, so thousands of target
+// approaches run per minute. Every approach starts from rest towards a random target; settle time and
+// overshoot over all approaches compare controller revisions (parameter files) with each other.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "ControlLoop.h"
+#include "MultirotorModel.h"
+#include "SimulatedSensors.h"
+
+static const int64_t CONTROL_PERIOD_NS = 14000000;     // Period of the control tick in main.cpp
+static const int PHYSICS_STEPS = 7;                     // Model steps per control tick
+static const int64_t START_NS = 1000000000;             // Simulated clock at the start of an approach
+static const double SETTLE_TAIL_S = 3.0;                // Observed after REACHED, the drone brakes in GPS hold
+static const GeoPosition ORIGIN = {51.9607, 7.6261, 0.0f};
+static const float START_ALTITUDE = 20.0f;
+
+struct Options {
+    int runs = 1000;
+    uint32_t seed = 1;
+    std::string parameter_file;
+    double wind = 0.0;          // m/s from a random direction per approach
+    double timeout = 120.0;     // Seconds per approach
+    std::string csv_file;
+    std::string record_file;    // Flight log of the approaches, see FlightRecorder.h
+};
+
+struct RunResult {
+    bool reached;
+    double distance;            // Meters to the target at the start
+    double settle_time;         // Seconds until REACHED
+    double overshoot;           // Meters beyond the target along the approach direction
+    double altitude_overshoot;  // Meters beyond the target altitude in the direction of the climb
+    double final_error;         // Meters to the target at the end of the tail
+};
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [--runs N] [--seed S] [--parameters FILE] [--wind M/S] [--timeout S] [--csv FILE] [--record FILE]\n", name);
+}
+
+static bool parse_options(int argc, char *argv[], Options &options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) return false;
+        const char *value = argv[++i];
+        if (option == "--runs") options.runs = atoi(value);
+        else if (option == "--seed") options.seed = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (option == "--parameters") options.parameter_file = value;
+        else if (option == "--wind") options.wind = atof(value);
+        else if (option == "--timeout") options.timeout = atof(value);
+        else if (option == "--csv") options.csv_file = value;
+        else if (option == "--record") options.record_file = value;
+        else return false;
+    }
+    return options.runs > 0 && options.timeout > 0.0;
+}
+
+static double percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(fraction * (values.size() - 1) + 0.5);
+    return values[index];
+}
+
+static double mean(const std::vector<double> &values) {
+    if (values.empty()) return 0.0;
+    double sum = 0.0;
+    for (double value : values) sum += value;
+    return sum / values.size();
+}
+
+static RunResult run_approach(const Options &options, const nlohmann::json &parameters, uint32_t seed, FlightRecorder *recorder) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    MultirotorConfig config = default_multirotor_config();
+    double wind_direction = 2.0 * M_PI * uniform(random);
+    config.wind_east = options.wind * std::sin(wind_direction);
+    config.wind_north = options.wind * std::cos(wind_direction);
+    MultirotorModel model(config);
+    model.reset({0.0, 0.0, START_ALTITUDE}, 360.0 * uniform(random));
+    SimulatedSensors sensors(ORIGIN, default_sensor_config(), seed);
+
+    std::unique_ptr<ControlLoop> control_loop(new ControlLoop(sensors, sensors));
+    std::string error;
+    control_loop->get_parameters().set(parameters, error);
+    control_loop->set_flight_recorder(recorder);
+
+    // Random target from rest
+    double distance = 10.0 + 140.0 * uniform(random);
+    double bearing = 2.0 * M_PI * uniform(random);
+    EnuPoint target = {distance * std::sin(bearing), distance * std::cos(bearing),
+                       START_ALTITUDE + static_cast<float>(30.0 * uniform(random) - 15.0)};
+    GeoPosition target_position = sensors.frame().to_geodetic(target);
+    float heading = static_cast<float>(360.0 * uniform(random));
+    float speed = static_cast<float>(10.0 + 26.0 * uniform(random));
+    float altitude_speed = static_cast<float>(3.6 + 3.6 * uniform(random));
+    float yaw_speed = static_cast<float>(20.0 + 40.0 * uniform(random));
+    control_loop->set_target(target_position.latitude, target_position.longitude, target_position.altitude,
+                             heading, speed, altitude_speed, yaw_speed);
+
+    double direction_east = std::sin(bearing);
+    double direction_north = std::cos(bearing);
+    double climb_sign = target.up >= START_ALTITUDE ? 1.0 : -1.0;
+
+    RunResult result = {false, distance, 0.0, 0.0, 0.0, 0.0};
+    int64_t end_ns = START_NS + static_cast<int64_t>(options.timeout * 1e9);
+    int64_t reached_ns = 0;
+    double physics_dt = CONTROL_PERIOD_NS * 1e-9 / PHYSICS_STEPS;
+
+    for (int64_t now_ns = START_NS; now_ns < end_ns; now_ns += CONTROL_PERIOD_NS) {
+        sensors.update(model.get_state(), now_ns);
+        control_loop->update_signals(sensors.get_fix_sample(), sensors.get_sample(), now_ns);
+        sbus_packet_t packet = control_loop->get_steering_signals();
+
+        for (int step = 0; step < PHYSICS_STEPS; ++step) {
+            model.step(packet, physics_dt);
+        }
+
+        const MultirotorState &state = model.get_state();
+        double beyond = (state.position.east - target.east) * direction_east + (state.position.north - target.north) * direction_north;
+        result.overshoot = std::max(result.overshoot, beyond);
+        result.altitude_overshoot = std::max(result.altitude_overshoot, climb_sign * (state.position.up - target.up));
+
+        ControlLoop::PositionControlState position_state = control_loop->get_position_control_state();
+        if (reached_ns == 0 && position_state == ControlLoop::PositionControlState::REACHED) {
+            reached_ns = now_ns;
+            result.reached = true;
+            result.settle_time = (now_ns - START_NS) * 1e-9;
+            end_ns = std::min(end_ns, now_ns + static_cast<int64_t>(SETTLE_TAIL_S * 1e9));
+        }
+        if (position_state == ControlLoop::PositionControlState::ABORTED) break;
+    }
+
+    const MultirotorState &state = model.get_state();
+    result.final_error = std::hypot(state.position.east - target.east, state.position.north - target.north);
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    ParameterStore parameters;
+    std::string error;
+    if (!options.parameter_file.empty() && !parameters.load_file(options.parameter_file, error)) {
+        std::cerr << "Invalid parameter file: " << error << std::endl;
+        return 1;
+    }
+    nlohmann::json parameter_values = parameters.to_json();
+
+    FILE *csv = nullptr;
+    if (!options.csv_file.empty()) {
+        csv = fopen(options.csv_file.c_str(), "w");
+        if (csv == nullptr) {
+            perror(options.csv_file.c_str());
+            return 1;
+        }
+        fprintf(csv, "run,seed,distance,reached,settle_time,overshoot,altitude_overshoot,final_error\n");
+    }
+
+    FlightRecorder recorder;
+    if (!options.record_file.empty() && !recorder.open(options.record_file, FlightRecorder::DEFAULT_CAPACITY, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    // The control loop reports every state change on stdout/stderr, too much for thousands of runs
+    std::streambuf *cout_buffer = std::cout.rdbuf(nullptr);
+    std::streambuf *cerr_buffer = std::cerr.rdbuf(nullptr);
+
+    std::vector<double> settle_times, overshoots, altitude_overshoots, final_errors;
+    int reached = 0;
+    auto wall_start = std::chrono::steady_clock::now();
+    for (int run = 0; run < options.runs; ++run) {
+        uint32_t seed = options.seed + static_cast<uint32_t>(run);
+        RunResult result = run_approach(options, parameter_values, seed, recorder.is_open() ? &recorder : nullptr);
+        if (result.reached) {
+            reached++;
+            settle_times.push_back(result.settle_time);
+            final_errors.push_back(result.final_error);
+        }
+        overshoots.push_back(result.overshoot);
+        altitude_overshoots.push_back(result.altitude_overshoot);
+        if (csv != nullptr) {
+            fprintf(csv, "%d,%u,%.2f,%d,%.3f,%.3f,%.3f,%.3f\n", run, seed, result.distance, result.reached ? 1 : 0,
+                    result.settle_time, result.overshoot, result.altitude_overshoot, result.final_error);
+        }
+    }
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+    std::cout.rdbuf(cout_buffer);
+    std::cerr.rdbuf(cerr_buffer);
+    if (csv != nullptr) fclose(csv);
+
+    printf("approaches          %d (seed %u, wind %.1f m/s)\n", options.runs, options.seed, options.wind);
+    printf("reached             %d (%.1f%%)\n", reached, 100.0 * reached / options.runs);
+    printf("settle time [s]     mean %7.2f  p50 %7.2f  p95 %7.2f  max %7.2f\n", mean(settle_times),
+           percentile(settle_times, 0.5), percentile(settle_times, 0.95), percentile(settle_times, 1.0));
+    printf("overshoot [m]       mean %7.2f  p50 %7.2f  p95 %7.2f  max %7.2f\n", mean(overshoots),
+           percentile(overshoots, 0.5), percentile(overshoots, 0.95), percentile(overshoots, 1.0));
+    printf("alt. overshoot [m]  mean %7.2f  p50 %7.2f  p95 %7.2f  max %7.2f\n", mean(altitude_overshoots),
+           percentile(altitude_overshoots, 0.5), percentile(altitude_overshoots, 0.95), percentile(altitude_overshoots, 1.0));
+    printf("final error [m]     mean %7.2f  p50 %7.2f  p95 %7.2f  max %7.2f\n", mean(final_errors),
+           percentile(final_errors, 0.5), percentile(final_errors, 0.95), percentile(final_errors, 1.0));
+    printf("wall time           %.2f s, %.0f approaches per minute\n", wall_s, options.runs / wall_s * 60.0);
+    return 0;
+}
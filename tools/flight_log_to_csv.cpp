@@ -0,0 +1,70 @@
+// Decodes a flight log written by the FlightRecorder into CSV, one line per control tick in the order
+// the ticks were recorded. Works on logs of a crashed process, torn records are skipped.
+// Usage: flight_log_to_csv <flight log> [csv file]
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "FlightRecorder.h"
+
+// In the order of ControlLoop::PositionControlState
+static const char *const STATE_NAMES[] = {"REACHED", "ACTIVE", "ABORTED", "PENDING"};
+
+static const char *state_name(uint8_t state) {
+    return state < sizeof(STATE_NAMES) / sizeof(STATE_NAMES[0]) ? STATE_NAMES[state] : "UNKNOWN";
+}
+
+static int flag(const FlightRecord &record, uint8_t mask) {
+    return (record.flags & mask) != 0 ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "Usage: %s <flight log> [csv file]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<FlightRecord> records;
+    std::string error;
+    if (!FlightRecorder::read_file(argv[1], records, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    FILE *out = stdout;
+    if (argc == 3) {
+        out = fopen(argv[2], "w");
+        if (out == nullptr) {
+            perror(argv[2]);
+            return 1;
+        }
+    }
+
+    fprintf(out, "sequence,session,tick_ns,duration_us,target_id,state,mission_leg,gps_stale,compass_stale,steering,holding,"
+                 "gps_latitude,gps_longitude,gps_altitude,gps_speed_kn,gps_course,gps_fix_quality,gps_satellites,gps_age_us,"
+                 "compass_heading,compass_age_us,"
+                 "estimate_latitude,estimate_longitude,estimate_altitude,estimate_heading,estimate_velocity_east,"
+                 "estimate_velocity_north,estimate_climb_rate,estimate_yaw_rate,"
+                 "target_east,target_north,target_up,target_heading,"
+                 "error_lateral,error_forward,error_altitude,error_heading,"
+                 "channel_roll,channel_pitch,channel_throttle,channel_yaw\n");
+    for (const FlightRecord &r : records) {
+        fprintf(out, "%" PRIu64 ",%u,%" PRId64 ",%.3f,%u,%s,%u,%d,%d,%d,%d,", r.sequence, r.session, r.tick_ns,
+                r.duration_ns / 1000.0, r.target_id, state_name(r.state), r.mission_leg,
+                flag(r, FlightRecord::FLAG_GPS_STALE), flag(r, FlightRecord::FLAG_COMPASS_STALE),
+                flag(r, FlightRecord::FLAG_STEERING), flag(r, FlightRecord::FLAG_HOLDING));
+        fprintf(out, "%.8f,%.8f,%.2f,%.2f,%.1f,%u,%u,%d,%.2f,%d,", r.gps_latitude, r.gps_longitude, r.gps_altitude,
+                r.gps_speed, r.gps_course, r.gps_fix_quality, r.gps_satellites, r.gps_age_us,
+                r.compass_heading, r.compass_age_us);
+        fprintf(out, "%.8f,%.8f,%.2f,%.2f,%.3f,%.3f,%.3f,%.2f,", r.estimate_latitude, r.estimate_longitude,
+                r.estimate_altitude, r.estimate_heading, r.estimate_velocity_east, r.estimate_velocity_north,
+                r.estimate_climb_rate, r.estimate_yaw_rate);
+        fprintf(out, "%.3f,%.3f,%.3f,%.2f,%.3f,%.3f,%.3f,%.2f,%u,%u,%u,%u\n", r.target_east, r.target_north,
+                r.target_up, r.target_heading, r.errors[0], r.errors[1], r.errors[2], r.errors[3],
+                r.channels[0], r.channels[1], r.channels[2], r.channels[3]);
+    }
+
+    if (out != stdout) fclose(out);
+    fprintf(stderr, "%zu records\n", records.size());
+    return 0;
+}